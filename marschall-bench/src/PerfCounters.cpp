@@ -0,0 +1,97 @@
+#include "PerfCounters.hpp"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    int openCounter(std::uint32_t type, std::uint64_t config) {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = type;
+        attributes.config = config;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+    }
+
+    constexpr std::uint64_t cacheConfig(std::uint64_t cache, std::uint64_t operation, std::uint64_t result) {
+        return cache | (operation << 8) | (result << 16);
+    }
+}
+
+PerfCounters::PerfCounters() {
+    files[Cycles] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    files[Instructions] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    files[L1DataMisses] = openCounter(PERF_TYPE_HW_CACHE,
+        cacheConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS));
+    files[LastLevelMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    files[BranchMisses] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+}
+
+PerfCounters::~PerfCounters() {
+    for (int file : files)
+        if (file != -1)
+            ::close(file);
+}
+
+void PerfCounters::start() {
+    for (int file : files) {
+        if (file == -1)
+            continue;
+        ::ioctl(file, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(file, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfCounters::Sample PerfCounters::stop() {
+    for (int file : files)
+        if (file != -1)
+            ::ioctl(file, PERF_EVENT_IOC_DISABLE, 0);
+
+    Sample sample;
+    for (std::size_t i = 0; i < CounterCount; ++i) {
+        if (files[i] == -1)
+            continue;
+
+        std::uint64_t values[3];
+        if (::read(files[i], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+            continue;
+
+        double scale = static_cast<double>(values[1]) / static_cast<double>(values[2]);
+        sample.values[i] = static_cast<std::uint64_t>(static_cast<double>(values[0]) * scale);
+        sample.available[i] = true;
+    }
+    return sample;
+}
+#else
+PerfCounters::PerfCounters() {
+    files.fill(-1);
+}
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::start() {
+}
+
+PerfCounters::Sample PerfCounters::stop() {
+    return {};
+}
+#endif
+
+std::string_view PerfCounters::name(Counter counter) {
+    switch (counter) {
+    case Cycles: return "cycles";
+    case Instructions: return "instr";
+    case L1DataMisses: return "L1d-miss";
+    case LastLevelMisses: return "LLC-miss";
+    case BranchMisses: return "br-miss";
+    default: return "";
+    }
+}
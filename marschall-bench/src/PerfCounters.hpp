@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Hardware performance counters of the current thread, read through Linux perf_event_open.
+ *
+ * Counters the kernel or CPU does not provide, for example inside virtual machines or with a restrictive
+ * perf_event_paranoid setting, are reported as unavailable. On other platforms all counters are unavailable.
+ */
+class PerfCounters
+{
+public:
+    enum Counter : std::size_t
+    {
+        Cycles,
+        Instructions,
+        L1DataMisses,
+        LastLevelMisses,
+        BranchMisses,
+        CounterCount
+    };
+
+    struct Sample
+    {
+        std::array<std::uint64_t, CounterCount> values{};
+        std::array<bool, CounterCount> available{};
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// Reset and start all available counters.
+    void start();
+
+    /// Stop all counters and return their values, scaled if the kernel multiplexed them.
+    Sample stop();
+
+    static std::string_view name(Counter counter);
+
+private:
+    std::array<int, CounterCount> files;
+};
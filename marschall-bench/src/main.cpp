@@ -0,0 +1,189 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "marschall.hpp"
+#include "PerfCounters.hpp"
+
+// Measures dispatcher scenarios, reporting wall time and hardware counters per dispatched event.
+// Usage: marschall-bench [events per scenario] [scenario name filter]
+
+namespace {
+    struct BenchEvent {
+        int value;
+    };
+
+    struct BenchPolymorphicEvent : EventBase<BenchPolymorphicEvent> {
+        int value = 0;
+    };
+
+    std::uint64_t sink = 0;
+
+    class BenchListener : public EventListener<BenchEvent> {
+    public:
+        constexpr BenchListener() = default;
+        void onEvent(const BenchEvent& event) override { sink += static_cast<std::uint64_t>(event.value); }
+    };
+
+    class BenchPolymorphicListener : public EventListener<BenchPolymorphicEvent> {
+    public:
+        void onEvent(const BenchPolymorphicEvent& event) override { sink += static_cast<std::uint64_t>(event.value); }
+    };
+
+    constinit BenchListener staticListener;
+
+    using BenchTable = StaticSubscriptionTable<StaticSubscription<staticListener, BenchEvent>>;
+
+    struct Scenario {
+        const char* name;
+        // Prepares the scenario and returns the measured body, which dispatches the given number of events.
+        std::function<std::function<void(std::size_t)>()> prepare;
+    };
+
+    template <std::size_t ListenerCount>
+    Scenario dispatchScenario(const char* name) {
+        return { name, [] {
+            auto dispatcher = std::make_shared<EventDispatcher>();
+            auto listeners = std::make_shared<std::vector<std::shared_ptr<BenchListener>>>();
+            for (std::size_t i = 0; i < ListenerCount; ++i) {
+                listeners->push_back(std::make_shared<BenchListener>());
+                dispatcher->subscribeTo<BenchEvent>(listeners->back());
+            }
+            return std::function<void(std::size_t)>([dispatcher, listeners](std::size_t events) {
+                for (std::size_t i = 0; i < events; ++i)
+                    dispatcher->dispatch(BenchEvent{ static_cast<int>(i) });
+            });
+        } };
+    }
+
+    std::vector<Scenario> scenarios() {
+        std::vector<Scenario> list;
+        list.push_back(dispatchScenario<1>("dispatch/1-listener"));
+        list.push_back(dispatchScenario<8>("dispatch/8-listeners"));
+        list.push_back(dispatchScenario<64>("dispatch/64-listeners"));
+
+        list.push_back({ "dispatch/polymorphic-base", [] {
+            auto dispatcher = std::make_shared<EventDispatcher>();
+            auto listener = std::make_shared<BenchPolymorphicListener>();
+            dispatcher->subscribeTo<BenchPolymorphicEvent>(listener);
+            return std::function<void(std::size_t)>([dispatcher, listener](std::size_t events) {
+                BenchPolymorphicEvent event;
+                const Event& base = event;
+                for (std::size_t i = 0; i < events; ++i) {
+                    event.value = static_cast<int>(i);
+                    dispatcher->dispatch(base);
+                }
+            });
+        } });
+
+        list.push_back({ "dispatch/static-table", [] {
+            auto dispatcher = std::make_shared<EventDispatcher>(BenchTable::topology);
+            return std::function<void(std::size_t)>([dispatcher](std::size_t events) {
+                for (std::size_t i = 0; i < events; ++i)
+                    dispatcher->dispatch(BenchEvent{ static_cast<int>(i) });
+            });
+        } });
+
+        list.push_back({ "dispatch/fixed", [] {
+            auto dispatcher = std::make_shared<FixedEventDispatcher<16, 8, 1024>>();
+            auto listener = std::make_shared<BenchListener>();
+            dispatcher->subscribeTo<BenchEvent>(listener);
+            return std::function<void(std::size_t)>([dispatcher, listener](std::size_t events) {
+                for (std::size_t i = 0; i < events; ++i)
+                    dispatcher->dispatch(BenchEvent{ static_cast<int>(i) });
+            });
+        } });
+
+        list.push_back({ "queue/by-value", [] {
+            auto dispatcher = std::make_shared<EventDispatcher>();
+            auto listener = std::make_shared<BenchListener>();
+            dispatcher->subscribeTo<BenchEvent>(listener);
+            return std::function<void(std::size_t)>([dispatcher, listener](std::size_t events) {
+                for (std::size_t i = 0; i < events; i += 1024) {
+                    for (std::size_t j = i; j < i + 1024 && j < events; ++j)
+                        dispatcher->queueEvent(BenchEvent{ static_cast<int>(j) });
+                    dispatcher->processQueue();
+                }
+            });
+        } });
+
+        list.push_back({ "queue/unique-ptr", [] {
+            auto dispatcher = std::make_shared<EventDispatcher>();
+            auto listener = std::make_shared<BenchPolymorphicListener>();
+            dispatcher->subscribeTo<BenchPolymorphicEvent>(listener);
+            return std::function<void(std::size_t)>([dispatcher, listener](std::size_t events) {
+                for (std::size_t i = 0; i < events; i += 1024) {
+                    for (std::size_t j = i; j < i + 1024 && j < events; ++j)
+                        dispatcher->queueEvent(std::make_unique<BenchPolymorphicEvent>());
+                    dispatcher->processQueue();
+                }
+            });
+        } });
+
+        list.push_back({ "queue/signal-queue", [] {
+            auto dispatcher = std::make_shared<EventDispatcher>();
+            auto queue = std::make_shared<SignalEventQueue>(1024);
+            auto listener = std::make_shared<BenchListener>();
+            dispatcher->setSignalQueue(queue);
+            dispatcher->subscribeTo<BenchEvent>(listener);
+            return std::function<void(std::size_t)>([dispatcher, queue, listener](std::size_t events) {
+                for (std::size_t i = 0; i < events; i += 1024) {
+                    for (std::size_t j = i; j < i + 1024 && j < events; ++j)
+                        queue->push(BenchEvent{ static_cast<int>(j) });
+                    dispatcher->processQueue();
+                }
+            });
+        } });
+
+        return list;
+    }
+
+    void printHeader() {
+        std::printf("%-28s %10s", "scenario", "ns/event");
+        for (std::size_t i = 0; i < PerfCounters::CounterCount; ++i)
+            std::printf(" %10.*s", static_cast<int>(PerfCounters::name(static_cast<PerfCounters::Counter>(i)).size()),
+                PerfCounters::name(static_cast<PerfCounters::Counter>(i)).data());
+        std::printf("\n");
+    }
+
+    void run(const Scenario& scenario, std::size_t events, PerfCounters& counters) {
+        auto body = scenario.prepare();
+        body(events / 10 + 1);
+
+        counters.start();
+        auto start = std::chrono::steady_clock::now();
+        body(events);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        PerfCounters::Sample sample = counters.stop();
+
+        double perEvent = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())
+            / static_cast<double>(events);
+        std::printf("%-28s %10.2f", scenario.name, perEvent);
+        for (std::size_t i = 0; i < PerfCounters::CounterCount; ++i) {
+            if (sample.available[i])
+                std::printf(" %10.3f", static_cast<double>(sample.values[i]) / static_cast<double>(events));
+            else
+                std::printf(" %10s", "n/a");
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t events = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const char* filter = argc > 2 ? argv[2] : nullptr;
+    if (events == 0)
+        events = 1;
+
+    PerfCounters counters;
+    printHeader();
+    for (const Scenario& scenario : scenarios())
+        if (!filter || std::strstr(scenario.name, filter))
+            run(scenario, events, counters);
+
+    std::fprintf(stderr, "checksum %llu\n", static_cast<unsigned long long>(sink));
+    return 0;
+}
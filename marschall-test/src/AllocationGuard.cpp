@@ -0,0 +1,102 @@
+#include "AllocationGuard.hpp"
+#include <cstdlib>
+#include <new>
+
+// Sanitizers interpose malloc themselves, so only count C allocations in regular glibc builds.
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define MARSCHALL_TEST_INTERPOSE_MALLOC
+extern "C" {
+    void* __libc_malloc(std::size_t size);
+    void* __libc_calloc(std::size_t count, std::size_t size);
+    void* __libc_realloc(void* memory, std::size_t size);
+}
+#endif
+
+namespace {
+    thread_local std::size_t activeGuards = 0;
+    thread_local std::size_t allocationCount = 0;
+
+    void countAllocation() noexcept {
+        if (activeGuards != 0)
+            ++allocationCount;
+    }
+
+    void* rawAllocate(std::size_t size) noexcept {
+#if defined(MARSCHALL_TEST_INTERPOSE_MALLOC)
+        return __libc_malloc(size ? size : 1);
+#else
+        return std::malloc(size ? size : 1);
+#endif
+    }
+
+    void* allocate(std::size_t size) {
+        countAllocation();
+        if (void* memory = rawAllocate(size))
+            return memory;
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+        countAllocation();
+        std::size_t align = static_cast<std::size_t>(alignment);
+        std::size_t rounded = (size + align - 1) / align * align;
+        if (void* memory = std::aligned_alloc(align, rounded ? rounded : align))
+            return memory;
+#if defined(__cpp_exceptions)
+        throw std::bad_alloc();
+#else
+        std::abort();
+#endif
+    }
+}
+
+AllocationGuard::AllocationGuard() : start(allocationCount) {
+    ++activeGuards;
+}
+
+AllocationGuard::~AllocationGuard() {
+    --activeGuards;
+}
+
+std::size_t AllocationGuard::allocations() const {
+    return allocationCount - start;
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { countAllocation(); return rawAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { countAllocation(); return rawAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+#if defined(MARSCHALL_TEST_INTERPOSE_MALLOC)
+extern "C" {
+    void* malloc(std::size_t size) {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* memory, std::size_t size) {
+        countAllocation();
+        return __libc_realloc(memory, size);
+    }
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+
+/*
+ * Counts heap allocations made by the current thread while the guard is alive.
+ *
+ * The test executable replaces the global operator new, and on glibc also malloc, calloc and realloc,
+ * to feed the counter. Guards may be nested.
+ */
+class AllocationGuard
+{
+public:
+    AllocationGuard();
+    ~AllocationGuard();
+
+    AllocationGuard(const AllocationGuard&) = delete;
+    AllocationGuard& operator=(const AllocationGuard&) = delete;
+
+    /// The number of allocations made by this thread since the guard was created.
+    std::size_t allocations() const;
+
+private:
+    std::size_t start;
+};
@@ -1,10 +1,34 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <csignal>
+#include <chrono>
 #include "marschall.hpp"
+#include "AllocationGuard.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 class TestEventA : public Event {};
 class TestEventB : public Event {};
 
+class TestValueEvent : public Event {
+public:
+    int value = 0;
+};
+
 class TestListenerA : public EventListener<TestEventA> {
 public:
     int callCount = 0;
@@ -174,6 +198,1759 @@ TEST(EventDispatcher, QueueEventUnsubscribedBeforeProcess) {
     EXPECT_EQ(listener->callCount, 0);
 }
 
+TEST(EventStream, ReaderSeesEventsDispatchedAfterCreation) {
+    EventDispatcher dispatcher;
+    TestValueEvent event;
+    event.value = 1;
+    dispatcher.dispatch(event);
+
+    auto reader = dispatcher.createReader<TestValueEvent>();
+    event.value = 2;
+    dispatcher.dispatch(event);
+    event.value = 3;
+    dispatcher.dispatch(event);
+
+    auto events = reader.read();
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].value, 2);
+    EXPECT_EQ(events[1].value, 3);
+    EXPECT_TRUE(reader.read().empty());
+}
+
+TEST(EventStream, ReadersHaveIndependentCursors) {
+    EventDispatcher dispatcher;
+    auto first = dispatcher.createReader<TestValueEvent>();
+    auto second = dispatcher.createReader<TestValueEvent>();
+
+    TestValueEvent event;
+    for (int i = 0; i < 3; ++i) {
+        event.value = i;
+        dispatcher.dispatch(event);
+    }
+    EXPECT_EQ(first.read().size(), 3u);
+
+    event.value = 3;
+    dispatcher.dispatch(event);
+
+    EXPECT_EQ(first.read().size(), 1u);
+    auto events = second.read();
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[3].value, 3);
+}
+
+TEST(EventStream, StorageReclaimedAfterAllReadersAdvance) {
+    auto stream = std::make_shared<EventStream<TestValueEvent>>();
+    auto first = stream->createReader();
+    auto second = stream->createReader();
+
+    TestValueEvent event;
+    for (int i = 0; i < 64; ++i)
+        stream->append(event);
+
+    first.read();
+    second.read();
+
+    for (int i = 0; i < 64; ++i)
+        stream->append(event);
+
+    EXPECT_EQ(stream->size(), 64u);
+    EXPECT_EQ(first.pending(), 64u);
+}
+
+TEST(EventStream, WorksAlongsideListenersAndQueue) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestListenerA>();
+    dispatcher.subscribeTo<TestEventA>(listener);
+    auto reader = dispatcher.createReader<TestEventA>();
+
+    dispatcher.queueEvent(std::make_unique<TestEventA>());
+    dispatcher.processQueue();
+
+    EXPECT_EQ(listener->callCount, 1);
+    EXPECT_EQ(reader.read().size(), 1u);
+}
+
+class TestValueListener : public EventListener<TestValueEvent> {
+public:
+    std::vector<int> values;
+    void onEvent(const TestValueEvent& event) override { values.push_back(event.value); }
+};
+
+TEST(EventRingBuffer, EveryConsumerSeesEveryEvent) {
+    EventRingBuffer<TestValueEvent, 8> ring;
+    auto first = std::make_shared<TestValueListener>();
+    auto second = std::make_shared<TestValueListener>();
+    auto& a = ring.addConsumer(first);
+    auto& b = ring.addConsumer(second);
+
+    TestValueEvent event;
+    for (int i = 0; i < 5; ++i) {
+        event.value = i;
+        EXPECT_TRUE(ring.tryPublish(event));
+    }
+
+    EXPECT_EQ(a.poll(), 5u);
+    EXPECT_EQ(b.poll(), 5u);
+    EXPECT_EQ(first->values, (std::vector<int>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(second->values, first->values);
+}
+
+TEST(EventRingBuffer, DependentConsumerWaitsForBarrier) {
+    EventRingBuffer<TestValueEvent, 8> ring;
+    auto physics = std::make_shared<TestValueListener>();
+    auto audio = std::make_shared<TestValueListener>();
+    auto& a = ring.addConsumer(physics);
+    auto& b = ring.addConsumer(audio, { &a });
+
+    TestValueEvent event;
+    ring.tryPublish(event);
+
+    EXPECT_EQ(b.poll(), 0u);
+    EXPECT_EQ(a.poll(), 1u);
+    EXPECT_EQ(b.poll(), 1u);
+    EXPECT_EQ(b.sequence(), 0);
+}
+
+TEST(EventRingBuffer, ProducerBlockedBySlowestConsumer) {
+    EventRingBuffer<TestValueEvent, 4> ring;
+    auto listener = std::make_shared<TestValueListener>();
+    auto& consumer = ring.addConsumer(listener);
+
+    TestValueEvent event;
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(ring.tryPublish(event));
+    EXPECT_FALSE(ring.tryPublish(event));
+
+    consumer.poll();
+    EXPECT_TRUE(ring.tryPublish(event));
+}
+
+TEST(EventRingBuffer, MultipleProducers) {
+    EventRingBuffer<TestValueEvent, 64, ProducerType::Multi> ring;
+    auto listener = std::make_shared<TestValueListener>();
+    auto& consumer = ring.addConsumer(listener);
+
+    constexpr int perProducer = 1000;
+    std::atomic<bool> done{ false };
+    std::thread reader([&] {
+        while (!done.load() || consumer.poll() != 0)
+            consumer.poll();
+    });
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p)
+        producers.emplace_back([&ring, p] {
+            TestValueEvent event;
+            for (int i = 0; i < perProducer; ++i) {
+                event.value = p * perProducer + i;
+                ring.publish(event);
+            }
+        });
+    for (auto& producer : producers)
+        producer.join();
+    done.store(true);
+    reader.join();
+
+    ASSERT_EQ(listener->values.size(), 4u * perProducer);
+    std::sort(listener->values.begin(), listener->values.end());
+    for (int i = 0; i < 4 * perProducer; ++i)
+        EXPECT_EQ(listener->values[i], i);
+}
+
+class TestOrderListener : public EventListener<TestEventA> {
+public:
+    TestOrderListener(std::vector<int>& log, std::mutex& mutex, int id) : log(log), mutex(mutex), id(id) {}
+    void onEvent(const TestEventA&) override {
+        std::lock_guard lock(mutex);
+        log.push_back(id);
+    }
+private:
+    std::vector<int>& log;
+    std::mutex& mutex;
+    int id;
+};
+
+static std::size_t indexOf(const std::vector<int>& log, int id) {
+    return static_cast<std::size_t>(std::find(log.begin(), log.end(), id) - log.begin());
+}
+
+TEST(EventDispatcher, RunsAfterIsHonoredSequentially) {
+    EventDispatcher dispatcher;
+    std::vector<int> log;
+    std::mutex mutex;
+    auto physics = std::make_shared<TestOrderListener>(log, mutex, 1);
+    auto audio = std::make_shared<TestOrderListener>(log, mutex, 2);
+    auto render = std::make_shared<TestOrderListener>(log, mutex, 3);
+
+    dispatcher.subscribeTo<TestEventA>(render, { audio.get(), physics.get() });
+    dispatcher.subscribeTo<TestEventA>(audio, { physics.get() });
+    dispatcher.subscribeTo<TestEventA>(physics);
+
+    dispatcher.dispatch(TestEventA{});
+
+    EXPECT_EQ(log, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(EventDispatcher, DependencyCycleStillNotifiesEveryone) {
+    EventDispatcher dispatcher;
+    std::vector<int> log;
+    std::mutex mutex;
+    auto first = std::make_shared<TestOrderListener>(log, mutex, 1);
+    auto second = std::make_shared<TestOrderListener>(log, mutex, 2);
+
+    dispatcher.subscribeTo<TestEventA>(first, { second.get() });
+    dispatcher.subscribeTo<TestEventA>(second, { first.get() });
+
+    dispatcher.dispatch(TestEventA{});
+
+    EXPECT_EQ(log.size(), 2u);
+}
+
+class TestUnsubscribingListener : public EventListener<TestEventA> {
+public:
+    EventDispatcher* dispatcher = nullptr;
+    std::shared_ptr<TestListenerA> victim;
+    int callCount = 0;
+    void onEvent(const TestEventA&) override {
+        ++callCount;
+        dispatcher->unsubscribeFrom<TestEventA>(victim);
+    }
+};
+
+TEST(EventDispatcher, UnsubscribingLaterListenerDuringDispatch) {
+    EventDispatcher dispatcher;
+    auto first = std::make_shared<TestUnsubscribingListener>();
+    auto victim = std::make_shared<TestListenerA>();
+    first->dispatcher = &dispatcher;
+    first->victim = victim;
+    dispatcher.subscribeTo<TestEventA>(first);
+    dispatcher.subscribeTo<TestEventA>(victim, { first.get() });
+
+    dispatcher.dispatch(TestEventA{});
+    dispatcher.dispatch(TestEventA{});
+    EXPECT_EQ(first->callCount, 2);
+    EXPECT_EQ(victim->callCount, 0);
+}
+
+class TestRedispatchingListener : public EventListener<TestEventA> {
+public:
+    EventDispatcher* dispatcher = nullptr;
+    int callCount = 0;
+    void onEvent(const TestEventA&) override {
+        if (++callCount == 1)
+            dispatcher->dispatch(TestEventA{});
+    }
+};
+
+TEST(EventDispatcher, RedispatchNotifiesOnceListenerOnce) {
+    for (bool onceFirst : { false, true }) {
+        EventDispatcher dispatcher;
+        auto redispatching = std::make_shared<TestRedispatchingListener>();
+        auto once = std::make_shared<TestListenerA>();
+        redispatching->dispatcher = &dispatcher;
+        if (onceFirst) {
+            dispatcher.subscribeOnceTo<TestEventA>(once);
+            dispatcher.subscribeTo<TestEventA>(redispatching, { once.get() });
+        } else {
+            dispatcher.subscribeTo<TestEventA>(redispatching);
+            dispatcher.subscribeOnceTo<TestEventA>(once, { redispatching.get() });
+        }
+
+        dispatcher.dispatch(TestEventA{});
+        dispatcher.dispatch(TestEventA{});
+        EXPECT_EQ(once->callCount, 1) << "once listener first: " << onceFirst;
+        EXPECT_EQ(redispatching->callCount, 3);
+    }
+}
+
+TEST(EventDispatcher, ParallelDispatchRespectsDependencies) {
+    EventDispatcher dispatcher;
+    dispatcher.setThreadPool(std::make_shared<ThreadPool>(4));
+
+    std::vector<int> log;
+    std::mutex mutex;
+    auto physics = std::make_shared<TestOrderListener>(log, mutex, 0);
+    dispatcher.subscribeTo<TestEventA>(physics);
+
+    std::vector<std::shared_ptr<TestOrderListener>> independent;
+    for (int i = 1; i <= 8; ++i) {
+        independent.push_back(std::make_shared<TestOrderListener>(log, mutex, i));
+        dispatcher.subscribeTo<TestEventA>(independent.back(), { physics.get() });
+    }
+    auto audio = std::make_shared<TestOrderListener>(log, mutex, 9);
+    dispatcher.subscribeTo<TestEventA>(audio, { independent[0].get(), independent[7].get() });
+
+    for (int round = 0; round < 50; ++round) {
+        log.clear();
+        dispatcher.dispatch(TestEventA{});
+
+        ASSERT_EQ(log.size(), 10u);
+        EXPECT_EQ(log.front(), 0);
+        EXPECT_GT(indexOf(log, 9), indexOf(log, 1));
+        EXPECT_GT(indexOf(log, 9), indexOf(log, 8));
+    }
+}
+
+TEST(EventDispatcher, ParallelDispatchRemovesExpiredSubscribers) {
+    EventDispatcher dispatcher;
+    dispatcher.setThreadPool(std::make_shared<ThreadPool>(2));
+    auto kept = std::make_shared<TestListenerA>();
+    auto once = std::make_shared<TestListenerA>();
+    dispatcher.subscribeTo<TestEventA>(kept);
+    dispatcher.subscribeOnceTo<TestEventA>(once);
+
+    dispatcher.dispatch(TestEventA{});
+    dispatcher.dispatch(TestEventA{});
+
+    EXPECT_EQ(kept->callCount, 2);
+    EXPECT_EQ(once->callCount, 1);
+}
+
+class TestQuery : public Event {
+public:
+    using Result = int;
+    int input = 0;
+};
+
+class TestResponder : public QueryListener<TestQuery> {
+public:
+    explicit TestResponder(int offset) : offset(offset) {}
+    int callCount = 0;
+    int onQuery(const TestQuery& query) override { ++callCount; return query.input + offset; }
+private:
+    int offset;
+};
+
+class TestCanHandle : public Event {
+public:
+    using Result = bool;
+};
+
+class TestHandler : public QueryListener<TestCanHandle> {
+public:
+    explicit TestHandler(bool canHandle) : canHandle(canHandle) {}
+    int callCount = 0;
+    bool onQuery(const TestCanHandle&) override { ++callCount; return canHandle; }
+private:
+    bool canHandle;
+};
+
+TEST(EventDispatcher, RequestCollectsResultsInline) {
+    EventDispatcher dispatcher;
+    auto first = std::make_shared<TestResponder>(1);
+    auto second = std::make_shared<TestResponder>(2);
+    dispatcher.subscribeResponder<TestQuery>(first);
+    dispatcher.subscribeResponder<TestQuery>(second);
+
+    TestQuery query;
+    query.input = 10;
+    auto results = dispatcher.request(query, CollectResults<int, 4>{});
+
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_TRUE(results.isInline());
+    EXPECT_EQ(results[0], 11);
+    EXPECT_EQ(results[1], 12);
+    EXPECT_EQ(dispatcher.request(query, SumResult<int>{}), 23);
+}
+
+TEST(EventDispatcher, RequestShortCircuits) {
+    EventDispatcher dispatcher;
+    auto no = std::make_shared<TestHandler>(false);
+    auto yes = std::make_shared<TestHandler>(true);
+    auto skipped = std::make_shared<TestHandler>(true);
+    dispatcher.subscribeResponder<TestCanHandle>(no);
+    dispatcher.subscribeResponder<TestCanHandle>(yes);
+    dispatcher.subscribeResponder<TestCanHandle>(skipped);
+
+    EXPECT_TRUE(dispatcher.request(TestCanHandle{}, AnyResult{}));
+    EXPECT_EQ(skipped->callCount, 0);
+
+    EXPECT_FALSE(dispatcher.request(TestCanHandle{}, AllResult{}));
+    EXPECT_EQ(yes->callCount, 1);
+
+    auto first = dispatcher.request(TestCanHandle{}, FirstResult<bool>{});
+    ASSERT_TRUE(first.has_value());
+    EXPECT_FALSE(*first);
+    EXPECT_EQ(no->callCount, 3);
+}
+
+TEST(EventDispatcher, RequestWithoutRespondersYieldsEmptyResult) {
+    EventDispatcher dispatcher;
+    auto responder = std::make_shared<TestResponder>(0);
+    dispatcher.subscribeResponder<TestQuery>(responder);
+    dispatcher.unsubscribeResponder<TestQuery>(responder);
+
+    EXPECT_FALSE(dispatcher.request(TestQuery{}, FirstResult<int>{}).has_value());
+    {
+        auto expired = std::make_shared<TestResponder>(0);
+        dispatcher.subscribeResponder<TestQuery>(expired);
+    }
+    EXPECT_TRUE(dispatcher.request(TestQuery{}, CollectResults<int>{}).empty());
+}
+
+TEST(SmallVector, SpillsToHeapBeyondInlineCapacity) {
+    SmallVector<std::string, 2> values;
+    values.push_back("a");
+    values.push_back("b");
+    EXPECT_TRUE(values.isInline());
+    values.push_back("c");
+    EXPECT_FALSE(values.isInline());
+
+    SmallVector<std::string, 2> moved = std::move(values);
+    ASSERT_EQ(moved.size(), 3u);
+    EXPECT_EQ(moved[2], "c");
+    EXPECT_TRUE(values.empty());
+}
+
+class TestPayloadEvent : public EventBase<TestPayloadEvent> {
+public:
+    TestPayloadEvent(std::string text, int* constructed) : text(std::move(text)) { ++*constructed; }
+    std::string text;
+};
+
+class TestPayloadListener : public EventListener<TestPayloadEvent> {
+public:
+    std::string last;
+    void onEvent(const TestPayloadEvent& event) override { last = event.text; }
+};
+
+TEST(EventDispatcher, DispatchEmplaceSkipsUnobservedEvents) {
+    EventDispatcher dispatcher;
+    int constructed = 0;
+
+    EXPECT_FALSE(dispatcher.dispatchEmplace<TestPayloadEvent>("ignored", &constructed));
+    EXPECT_EQ(constructed, 0);
+
+    auto listener = std::make_shared<TestPayloadListener>();
+    dispatcher.subscribeTo<TestPayloadEvent>(listener);
+
+    EXPECT_TRUE(dispatcher.dispatchEmplace<TestPayloadEvent>("payload", &constructed));
+    EXPECT_EQ(constructed, 1);
+    EXPECT_EQ(listener->last, "payload");
+}
+
+TEST(EventDispatcher, DispatchLazyOnlyInvokesFactoryWhenObserved) {
+    EventDispatcher dispatcher;
+    int constructed = 0;
+    auto factory = [&constructed] { return TestPayloadEvent("lazy", &constructed); };
+
+    EXPECT_FALSE(dispatcher.dispatchLazy<TestPayloadEvent>(factory));
+    EXPECT_FALSE(dispatcher.hasSubscribers<TestPayloadEvent>());
+    EXPECT_EQ(constructed, 0);
+
+    auto reader = dispatcher.createReader<TestValueEvent>();
+    EXPECT_TRUE(dispatcher.hasSubscribers<TestValueEvent>());
+
+    auto listener = std::make_shared<TestPayloadListener>();
+    dispatcher.subscribeTo<TestPayloadEvent>(listener);
+    EXPECT_TRUE(dispatcher.dispatchLazy<TestPayloadEvent>(factory));
+    EXPECT_EQ(constructed, 1);
+    EXPECT_EQ(listener->last, "lazy");
+}
+
+TEST(EventDispatcher, QueueEmplace) {
+    EventDispatcher dispatcher;
+    int constructed = 0;
+    auto listener = std::make_shared<TestPayloadListener>();
+    dispatcher.subscribeTo<TestPayloadEvent>(listener);
+
+    dispatcher.queueEmplace<TestPayloadEvent>("queued", &constructed);
+    EXPECT_EQ(listener->last, "");
+
+    dispatcher.processQueue();
+    EXPECT_EQ(constructed, 1);
+    EXPECT_EQ(listener->last, "queued");
+}
+
+class TestBufferEvent : public Event {
+public:
+    std::vector<int> buffer;
+};
+
+class TestBufferReader : public EventListener<TestBufferEvent> {
+public:
+    std::size_t seenSize = 0;
+    void onEvent(const TestBufferEvent& event) override { seenSize = event.buffer.size(); }
+};
+
+class TestBufferConsumer : public EventConsumer<TestBufferEvent> {
+public:
+    std::vector<int> owned;
+    const int* ownedData = nullptr;
+    void onEvent(TestBufferEvent&& event) override {
+        owned = std::move(event.buffer);
+        ownedData = owned.data();
+    }
+};
+
+TEST(EventDispatcher, RvalueDispatchMovesIntoConsumerAfterListeners) {
+    EventDispatcher dispatcher;
+    auto reader = std::make_shared<TestBufferReader>();
+    auto consumer = std::make_shared<TestBufferConsumer>();
+    dispatcher.subscribeConsumerTo<TestBufferEvent>(consumer);
+    dispatcher.subscribeTo<TestBufferEvent>(reader);
+
+    TestBufferEvent event;
+    event.buffer.assign(1000, 7);
+    const int* data = event.buffer.data();
+    dispatcher.dispatch(std::move(event));
+
+    EXPECT_EQ(reader->seenSize, 1000u);
+    EXPECT_EQ(consumer->owned.size(), 1000u);
+    EXPECT_EQ(consumer->ownedData, data);
+}
+
+TEST(EventDispatcher, LvalueDispatchCopiesIntoConsumer) {
+    EventDispatcher dispatcher;
+    auto consumer = std::make_shared<TestBufferConsumer>();
+    dispatcher.subscribeConsumerTo<TestBufferEvent>(consumer);
+
+    TestBufferEvent event;
+    event.buffer.assign(3, 1);
+    dispatcher.dispatch(event);
+
+    EXPECT_EQ(event.buffer.size(), 3u);
+    EXPECT_EQ(consumer->owned.size(), 3u);
+
+    dispatcher.unsubscribeConsumerFrom<TestBufferEvent>(consumer);
+    consumer->owned.clear();
+    dispatcher.dispatch(event);
+    EXPECT_TRUE(consumer->owned.empty());
+}
+
+TEST(EventDispatcher, QueuedEventsAreMovedIntoConsumer) {
+    EventDispatcher dispatcher;
+    auto consumer = std::make_shared<TestBufferConsumer>();
+    dispatcher.subscribeConsumerTo<TestBufferEvent>(consumer);
+
+    auto event = std::make_unique<TestBufferEvent>();
+    event->buffer.assign(10, 2);
+    const int* data = event->buffer.data();
+    dispatcher.queueEvent(std::move(event));
+    dispatcher.processQueue();
+
+    EXPECT_EQ(consumer->ownedData, data);
+}
+
+struct TestPlainEvent {
+    int id;
+    float value;
+};
+
+static_assert(std::is_trivially_copyable_v<TestPlainEvent>);
+static_assert(sizeof(TestPlainEvent) == 2 * sizeof(int));
+
+class TestPlainListener : public EventListener<TestPlainEvent> {
+public:
+    std::vector<int> ids;
+    void onEvent(const TestPlainEvent& event) override { ids.push_back(event.id); }
+};
+
+static_assert(!EventType<std::unique_ptr<TestPlainEvent>>, "smart pointers are not events");
+static_assert(!EventType<std::shared_ptr<TestPlainEvent>>, "smart pointers are not events");
+
+#if defined(__cpp_rtti)
+TEST(EventDispatcher, DispatchEventSubclassThroughBase) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestListenerA>();
+    dispatcher.subscribeTo<TestEventA>(listener);
+
+    TestEventA event;
+    const Event& base = event;
+    dispatcher.dispatch(base);
+    dispatcher.queueEvent(std::unique_ptr<Event>(std::make_unique<TestEventA>()));
+    dispatcher.queueEvent(std::unique_ptr<Event>(std::make_unique<TestEventB>()));
+    dispatcher.processQueue();
+
+    EXPECT_EQ(listener->callCount, 2);
+}
+#elif !defined(NDEBUG)
+TEST(EventDispatcherDeathTest, DispatchEventSubclassThroughBase) {
+    EventDispatcher dispatcher;
+    TestEventA event;
+    const Event& base = event;
+    EXPECT_DEATH(dispatcher.dispatch(base), "EventBase");
+}
+#endif
+
+TEST(EventDispatcher, DispatchPlainEvent) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(listener);
+    auto reader = dispatcher.createReader<TestPlainEvent>();
+
+    TestPlainEvent event{ 1, 0.5f };
+    dispatcher.dispatch(event);
+    dispatcher.dispatchEmplace<TestPlainEvent>(2, 1.5f);
+
+    EXPECT_EQ(listener->ids, (std::vector<int>{1, 2}));
+    EXPECT_EQ(reader.read().size(), 2u);
+}
+
+TEST(EventDispatcher, QueuePlainEventsByValue) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(listener);
+
+    for (int i = 0; i < 1000; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ i, 0.0f });
+    dispatcher.queueEmplace<TestPlainEvent>(1000, 0.0f);
+
+    dispatcher.processQueue();
+
+    ASSERT_EQ(listener->ids.size(), 1001u);
+    for (int i = 0; i <= 1000; ++i)
+        EXPECT_EQ(listener->ids[i], i);
+}
+
+TEST(EventDispatcher, QueueMixesPlainAndPolymorphicEvents) {
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    auto polymorphic = std::make_shared<TestPayloadListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.subscribeTo<TestPayloadEvent>(polymorphic);
+
+    int constructed = 0;
+    dispatcher.queueEvent(TestPlainEvent{ 7, 0.0f });
+    dispatcher.queueEvent(TestPayloadEvent(std::string(100, 'x'), &constructed));
+    std::unique_ptr<Event> owned = std::make_unique<TestPayloadEvent>("owned", &constructed);
+    dispatcher.queueEvent(std::move(owned));
+
+    dispatcher.processQueue();
+
+    EXPECT_EQ(plain->ids, (std::vector<int>{7}));
+    EXPECT_EQ(polymorphic->last, "owned");
+}
+
+class TestBaseEvent : public EventBase<TestBaseEvent> {};
+class TestDerivedEvent : public TestBaseEvent {
+public:
+    EventTypeKey getTypeKey() const noexcept override { return eventTypeKey<TestDerivedEvent>(); }
+};
+
+class TestDerivedListener : public EventListener<TestDerivedEvent> {
+public:
+    int callCount = 0;
+    void onEvent(const TestDerivedEvent&) override { ++callCount; }
+};
+
+TEST(EventType, KeysAreUniquePerType) {
+    static_assert(eventTypeKey<TestEventA>() == eventTypeKey<TestEventA>());
+    EXPECT_NE(eventTypeKey<TestEventA>(), eventTypeKey<TestEventB>());
+    EXPECT_NE(eventTypeKey<TestPlainEvent>(), eventTypeKey<TestValueEvent>());
+}
+
+TEST(EventType, NamesAreResolvedAtCompileTime) {
+    static_assert(eventTypeName<TestPlainEvent>() == "TestPlainEvent");
+    EXPECT_EQ(eventTypeName<TestEventA>(), "TestEventA");
+
+    TestBaseEvent event;
+    const Event& base = event;
+    EXPECT_EQ(base.getTypeName(), "TestBaseEvent");
+}
+
+TEST(EventDispatcher, DispatchThroughBaseUsesConcreteType) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestDerivedListener>();
+    dispatcher.subscribeTo<TestDerivedEvent>(listener);
+
+    TestDerivedEvent event;
+    const Event& base = event;
+    dispatcher.dispatch(base);
+    dispatcher.dispatch(static_cast<const TestBaseEvent&>(event));
+    dispatcher.queueEvent(std::unique_ptr<TestBaseEvent>(new TestDerivedEvent()));
+    dispatcher.processQueue();
+
+    EXPECT_EQ(listener->callCount, 3);
+}
+
+struct TestControlEvent {
+    int channel;
+    float gain;
+};
+
+class TestControlListener : public EventListener<TestControlEvent> {
+public:
+    int callCount = 0;
+    float lastGain = 0.0f;
+    void onEvent(const TestControlEvent& event) override { ++callCount; lastGain = event.gain; }
+};
+
+TEST(AllocationGuard, DetectsAllocations) {
+    AllocationGuard guard;
+    auto memory = std::make_unique<int>(1);
+    void* raw = std::malloc(16);
+    std::free(raw);
+    EXPECT_GE(guard.allocations(), 1u);
+}
+
+TEST(FixedEventDispatcher, HotPathDoesNotAllocate) {
+    auto dispatcher = std::make_unique<FixedEventDispatcher<8, 4, 16>>();
+    auto listener = std::make_shared<TestControlListener>();
+    auto plain = std::make_shared<TestPlainListener>();
+    ASSERT_TRUE(dispatcher->subscribeTo<TestControlEvent>(listener));
+    ASSERT_TRUE(dispatcher->subscribeTo<TestPlainEvent>(plain));
+    plain->ids.reserve(100);
+
+    int queued = 0;
+    std::size_t allocations = 0;
+    {
+        AllocationGuard guard;
+        for (int i = 0; i < 100; ++i) {
+            dispatcher->dispatch(TestControlEvent{ 0, 0.5f });
+            queued += dispatcher->queueEvent(TestControlEvent{ 1, 1.0f });
+            queued += dispatcher->queueEvent(TestPlainEvent{ i, 0.0f });
+            dispatcher->processQueue();
+        }
+        allocations = guard.allocations();
+    }
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(queued, 200);
+
+    EXPECT_EQ(listener->callCount, 200);
+    EXPECT_EQ(listener->lastGain, 1.0f);
+    EXPECT_EQ(plain->ids.size(), 100u);
+}
+
+TEST(FixedEventDispatcher, CapacitiesAreEnforced) {
+    FixedEventDispatcher<1, 1, 2> dispatcher;
+    auto first = std::make_shared<TestControlListener>();
+    auto second = std::make_shared<TestControlListener>();
+    auto other = std::make_shared<TestPlainListener>();
+
+    EXPECT_TRUE(dispatcher.subscribeTo<TestControlEvent>(first));
+    EXPECT_FALSE(dispatcher.subscribeTo<TestControlEvent>(second));
+    EXPECT_FALSE(dispatcher.subscribeTo<TestPlainEvent>(other));
+
+    EXPECT_TRUE(dispatcher.queueEvent(TestControlEvent{}));
+    EXPECT_TRUE(dispatcher.queueEvent(TestControlEvent{}));
+    EXPECT_FALSE(dispatcher.queueEvent(TestControlEvent{}));
+    dispatcher.processQueue();
+    EXPECT_EQ(first->callCount, 2);
+    EXPECT_EQ(dispatcher.queueSize(), 0u);
+}
+
+TEST(FixedEventDispatcher, RemovesExpiredAndUnsubscribedListeners) {
+    FixedEventDispatcher<4, 2, 4> dispatcher;
+    auto kept = std::make_shared<TestControlListener>();
+    {
+        auto expired = std::make_shared<TestControlListener>();
+        dispatcher.subscribeTo<TestControlEvent>(expired);
+    }
+    dispatcher.subscribeTo<TestControlEvent>(kept);
+    dispatcher.dispatch(TestControlEvent{});
+
+    auto replacement = std::make_shared<TestControlListener>();
+    EXPECT_TRUE(dispatcher.subscribeTo<TestControlEvent>(replacement));
+
+    dispatcher.unsubscribeFrom<TestControlEvent>(kept);
+    dispatcher.dispatch(TestControlEvent{});
+    EXPECT_EQ(kept->callCount, 1);
+    EXPECT_EQ(replacement->callCount, 1);
+}
+
+struct TestStaticEvent {
+    int value = 0;
+};
+
+int testStaticLog[16];
+int testStaticLogSize = 0;
+
+class TestStaticListener : public EventListener<TestStaticEvent> {
+public:
+    constexpr explicit TestStaticListener(int tag) : tag(tag) {}
+    void onEvent(const TestStaticEvent& event) override { testStaticLog[testStaticLogSize++] = tag * 100 + event.value; }
+
+private:
+    int tag;
+};
+
+constinit TestStaticListener testStaticLow{ 1 };
+constinit TestStaticListener testStaticHigh{ 2 };
+constinit TestStaticListener testStaticDefault{ 3 };
+constinit TestPlainListener testStaticPlain;
+
+using TestStaticTable = StaticSubscriptionTable<
+    StaticSubscription<testStaticLow, TestStaticEvent, -1>,
+    StaticSubscription<testStaticPlain, TestPlainEvent>,
+    StaticSubscription<testStaticDefault, TestStaticEvent>,
+    StaticSubscription<testStaticHigh, TestStaticEvent, 5>>;
+
+TEST(StaticSubscriptions, NotifiesInPriorityOrder) {
+    static_assert(TestStaticTable::size() == 4);
+    static_assert(TestStaticTable::observes<TestStaticEvent>());
+    static_assert(!TestStaticTable::observes<TestValueEvent>());
+
+    testStaticLogSize = 0;
+    TestStaticTable::dispatch(TestStaticEvent{ 7 });
+
+    ASSERT_EQ(testStaticLogSize, 3);
+    EXPECT_EQ(testStaticLog[0], 207);
+    EXPECT_EQ(testStaticLog[1], 307);
+    EXPECT_EQ(testStaticLog[2], 107);
+}
+
+TEST(StaticSubscriptions, DispatcherNotifiesStaticBeforeDynamicListeners) {
+    EventDispatcher dispatcher{ TestStaticTable::topology };
+    EXPECT_TRUE(dispatcher.hasSubscribers<TestStaticEvent>());
+    EXPECT_TRUE(dispatcher.hasSubscribers<TestPlainEvent>());
+    EXPECT_FALSE(dispatcher.hasSubscribers<TestValueEvent>());
+
+    struct DynamicListener : EventListener<TestStaticEvent> {
+        void onEvent(const TestStaticEvent& event) override { testStaticLog[testStaticLogSize++] = 900 + event.value; }
+    };
+    auto dynamic = std::make_shared<DynamicListener>();
+    dispatcher.subscribeTo<TestStaticEvent>(dynamic);
+
+    testStaticLogSize = 0;
+    dispatcher.dispatch(TestStaticEvent{ 1 });
+    dispatcher.queueEvent(TestStaticEvent{ 2 });
+    dispatcher.processQueue();
+    EXPECT_TRUE(dispatcher.dispatchEmplace<TestStaticEvent>(3));
+
+    const int expected[] = { 201, 301, 101, 901, 202, 302, 102, 902, 203, 303, 103, 903 };
+    ASSERT_EQ(testStaticLogSize, 12);
+    EXPECT_TRUE(std::equal(std::begin(expected), std::end(expected), testStaticLog));
+
+    testStaticPlain.ids.clear();
+    dispatcher.dispatch(TestPlainEvent{ 4, 0.0f });
+    ASSERT_EQ(testStaticPlain.ids.size(), 1u);
+    EXPECT_EQ(testStaticPlain.ids[0], 4);
+}
+
+TEST(StaticSubscriptions, AttachingAndDispatchingDoesNotAllocate) {
+    std::size_t emptyAllocations = 0;
+    std::size_t attachAllocations = 0;
+    std::size_t dispatchAllocations = 0;
+    testStaticLogSize = 0;
+    {
+        AllocationGuard guard;
+        {
+            EventDispatcher empty;
+        }
+        emptyAllocations = guard.allocations();
+
+        EventDispatcher dispatcher{ TestStaticTable::topology };
+        attachAllocations = guard.allocations() - emptyAllocations;
+
+        dispatcher.dispatch(TestStaticEvent{ 5 });
+        dispatchAllocations = guard.allocations() - emptyAllocations - attachAllocations;
+    }
+
+    EXPECT_EQ(attachAllocations, emptyAllocations);
+    EXPECT_EQ(dispatchAllocations, 0u);
+    EXPECT_EQ(testStaticLogSize, 3);
+}
+
+SignalEventQueue* testSignalQueue = nullptr;
+
+extern "C" void testSignalHandler(int signal) {
+    testSignalQueue->push(TestPlainEvent{ signal, 0.0f });
+}
+
+TEST(SignalEventQueue, DeliversEventsRaisedInSignalHandlers) {
+    EventDispatcher dispatcher;
+    auto queue = std::make_shared<SignalEventQueue>(8);
+    dispatcher.setSignalQueue(queue);
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+
+    testSignalQueue = queue.get();
+    auto previous = std::signal(SIGINT, testSignalHandler);
+    std::raise(SIGINT);
+    std::raise(SIGINT);
+    std::signal(SIGINT, previous);
+    testSignalQueue = nullptr;
+
+    dispatcher.queueEvent(TestPlainEvent{ 0, 0.0f });
+    EXPECT_FALSE(queue->empty());
+    dispatcher.processQueue();
+    EXPECT_TRUE(queue->empty());
+    EXPECT_EQ(plain->ids, (std::vector<int>{ SIGINT, SIGINT, 0 }));
+}
+
+TEST(SignalEventQueue, PushNeverBlocksOrAllocates) {
+    SignalEventQueue queue(3);
+    EXPECT_EQ(queue.capacity(), 4u);
+
+    std::size_t allocations = 0;
+    int accepted = 0;
+    {
+        AllocationGuard guard;
+        for (int i = 0; i < 6; ++i)
+            accepted += queue.push(TestControlEvent{ i, 0.0f });
+        allocations = guard.allocations();
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(accepted, 4);
+    EXPECT_EQ(queue.dropped(), 2u);
+
+    std::vector<int> channels;
+    queue.drain([&channels](EventTypeKey key, void* event) {
+        EXPECT_EQ(key, eventTypeKey<TestControlEvent>());
+        channels.push_back(static_cast<TestControlEvent*>(event)->channel);
+    });
+    EXPECT_EQ(channels, (std::vector<int>{ 0, 1, 2, 3 }));
+}
+
+TEST(SignalEventQueue, ConcurrentProducers) {
+    SignalEventQueue queue(1024);
+    constexpr int threadCount = 4;
+    constexpr int perThread = 10000;
+
+    std::atomic<bool> done{ false };
+    std::vector<int> counts(threadCount, 0);
+    std::thread consumer([&] {
+        auto drainAll = [&] {
+            queue.drain([&counts](EventTypeKey, void* event) {
+                ++counts[static_cast<TestPlainEvent*>(event)->id];
+            });
+        };
+        while (!done.load())
+            drainAll();
+        drainAll();
+    });
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < threadCount; ++t) {
+        producers.emplace_back([&queue, t] {
+            for (int i = 0; i < perThread; ++i)
+                while (!queue.push(TestPlainEvent{ t, 0.0f }))
+                    std::this_thread::yield();
+        });
+    }
+    for (auto& producer : producers)
+        producer.join();
+    done = true;
+    consumer.join();
+
+    for (int t = 0; t < threadCount; ++t)
+        EXPECT_EQ(counts[t], perThread);
+}
+
+class TestSlowListener : public EventListener<TestEventA> {
+public:
+    int callCount = 0;
+    void onEvent(const TestEventA&) override {
+        ++callCount;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+};
+
+TEST(ListenerWatchdog, QuarantinesRepeatedlySlowListeners) {
+    EventDispatcher dispatcher;
+    auto slow = std::make_shared<TestSlowListener>();
+    auto fast = std::make_shared<TestListenerA>();
+    dispatcher.subscribeTo<TestEventA>(slow);
+    dispatcher.subscribeTo<TestEventA>(fast);
+    dispatcher.setListenerWatchdog({ std::chrono::milliseconds(1), 1, 2 });
+
+    for (int i = 0; i < 4; ++i)
+        dispatcher.dispatch(TestEventA{});
+
+    EXPECT_EQ(slow->callCount, 2);
+    EXPECT_EQ(fast->callCount, 4);
+
+    std::vector<SlowListener> report = dispatcher.slowListeners();
+    ASSERT_EQ(report.size(), 1u);
+    EXPECT_EQ(report[0].type, eventTypeKey<TestEventA>());
+    EXPECT_EQ(report[0].listener, slow.get());
+    EXPECT_EQ(report[0].violations, 2u);
+    EXPECT_GE(report[0].worst, std::chrono::milliseconds(1));
+    EXPECT_TRUE(report[0].quarantined);
+
+    dispatcher.restoreListener<TestEventA>(slow);
+    dispatcher.dispatch(TestEventA{});
+    EXPECT_EQ(slow->callCount, 3);
+}
+
+TEST(ListenerWatchdog, OnlySampledDispatchesAreTimed) {
+    EventDispatcher dispatcher;
+    auto slow = std::make_shared<TestSlowListener>();
+    dispatcher.subscribeTo<TestEventA>(slow);
+    dispatcher.setListenerWatchdog({ std::chrono::milliseconds(1), 4, 0 });
+
+    for (int i = 0; i < 8; ++i)
+        dispatcher.dispatch(TestEventA{});
+
+    std::vector<SlowListener> report = dispatcher.slowListeners();
+    ASSERT_EQ(report.size(), 1u);
+    EXPECT_EQ(report[0].violations, 2u);
+    EXPECT_FALSE(report[0].quarantined);
+    EXPECT_EQ(slow->callCount, 8);
+}
+
+TEST(EventDispatcher, MemoryUsageIsReportedPerType) {
+    EventDispatcher dispatcher;
+    auto listenerA = std::make_shared<TestListenerA>();
+    auto listenerB = std::make_shared<TestListenerB>();
+    dispatcher.subscribeTo<TestEventA>(listenerA);
+    dispatcher.subscribeTo<TestEventB>(listenerB);
+    dispatcher.dispatch(TestEventA{});
+
+    DispatcherMemoryUsage usage = dispatcher.memoryUsage();
+    ASSERT_EQ(usage.types.size(), 2u);
+    std::size_t sum = usage.table + usage.queue;
+    for (const DispatcherMemoryUsage::Type& type : usage.types) {
+        EXPECT_GT(type.subscribers, 0u);
+        sum += type.subscribers + type.responders + type.stream;
+    }
+    EXPECT_EQ(usage.total, sum);
+}
+
+TEST(EventDispatcher, ShrinkRemovesUnobservedTypesAndSpareQueueStorage) {
+    EventDispatcher dispatcher;
+    auto listenerA = std::make_shared<TestListenerA>();
+    auto listenerB = std::make_shared<TestListenerB>();
+    dispatcher.subscribeTo<TestEventA>(listenerA);
+    dispatcher.subscribeTo<TestEventB>(listenerB);
+    dispatcher.unsubscribeFrom<TestEventB>(listenerB);
+
+    for (int i = 0; i < 1000; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ i, 0.0f });
+    dispatcher.processQueue();
+
+    DispatcherMemoryUsage before = dispatcher.memoryUsage();
+    EXPECT_EQ(before.types.size(), 2u);
+    EXPECT_GT(before.queue, 0u);
+
+    dispatcher.shrink();
+
+    DispatcherMemoryUsage after = dispatcher.memoryUsage();
+    ASSERT_EQ(after.types.size(), 1u);
+    EXPECT_EQ(after.types[0].type, eventTypeKey<TestEventA>());
+    EXPECT_EQ(after.queue, 0u);
+    EXPECT_LT(after.total, before.total);
+
+    dispatcher.dispatch(TestEventA{});
+    EXPECT_EQ(listenerA->callCount, 1);
+}
+
+/// Allocator counting deallocations, to observe when a listener's allocation is released.
+template <typename T>
+struct TestCountingAllocator {
+    using value_type = T;
+    int* freed;
+
+    explicit TestCountingAllocator(int* freed) : freed(freed) {}
+    template <typename U>
+    TestCountingAllocator(const TestCountingAllocator<U>& other) : freed(other.freed) {}
+
+    T* allocate(std::size_t n) { return std::allocator<T>{}.allocate(n); }
+    void deallocate(T* p, std::size_t n) {
+        ++*freed;
+        std::allocator<T>{}.deallocate(p, n);
+    }
+    friend bool operator==(const TestCountingAllocator&, const TestCountingAllocator&) = default;
+};
+
+TEST(EventDispatcher, SweepReleasesExpiredListenersWithoutDispatch) {
+    EventDispatcher dispatcher;
+    int freed = 0;
+    auto listenerA = std::allocate_shared<TestListenerA>(TestCountingAllocator<TestListenerA>(&freed));
+    auto listenerB = std::allocate_shared<TestListenerB>(TestCountingAllocator<TestListenerB>(&freed));
+    auto keptB = std::make_shared<TestListenerB>();
+    dispatcher.subscribeTo<TestEventA>(listenerA);
+    dispatcher.subscribeOnceTo<TestEventB>(listenerB);
+    dispatcher.subscribeTo<TestEventB>(keptB);
+
+    listenerA.reset();
+    listenerB.reset();
+    EXPECT_EQ(freed, 0);
+
+    std::size_t removed = 0;
+    for (int i = 0; i < 1000 && removed < 2; ++i)
+    {
+        std::size_t swept = dispatcher.sweepExpired(1);
+        EXPECT_LE(swept, 1u);
+        removed += swept;
+        EXPECT_EQ(freed, static_cast<int>(removed));
+    }
+    EXPECT_EQ(removed, 2u);
+    EXPECT_EQ(dispatcher.sweepExpired(100), 0u);
+
+    dispatcher.dispatch(TestEventB{});
+    EXPECT_EQ(keptB->callCount, 1);
+}
+
+TEST(EventDispatcher, SweepBudgetBoundsSubscribersOfOneType) {
+    EventDispatcher dispatcher;
+    int freed = 0;
+    std::vector<std::shared_ptr<TestListenerA>> listeners;
+    for (int i = 0; i < 1000; ++i)
+    {
+        listeners.push_back(std::allocate_shared<TestListenerA>(TestCountingAllocator<TestListenerA>(&freed)));
+        dispatcher.subscribeTo<TestEventA>(listeners.back());
+    }
+    listeners.clear();
+
+    std::size_t removed = 0;
+    for (int i = 0; i < 1000 && removed < 1000; ++i)
+    {
+        std::size_t swept = dispatcher.sweepExpired(8);
+        EXPECT_LE(swept, 16u);
+        removed += swept;
+    }
+    EXPECT_EQ(removed, 1000u);
+    EXPECT_EQ(freed, 1000);
+}
+
+TEST(EventDispatcher, ProcessQueueSweepsWithinBudget) {
+    EventDispatcher dispatcher;
+    int freed = 0;
+    auto listener = std::allocate_shared<TestListenerA>(TestCountingAllocator<TestListenerA>(&freed));
+    dispatcher.subscribeTo<TestEventA>(listener);
+    dispatcher.setSweepBudget(8);
+
+    listener.reset();
+    for (int i = 0; i < 100 && freed == 0; ++i)
+        dispatcher.processQueue();
+    EXPECT_EQ(freed, 1);
+}
+
+TEST(EventTransaction, CommittedEventsAreProcessedContiguously) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(listener);
+
+    EventTransaction transaction;
+    dispatcher.queueEvent(TestPlainEvent{ 1, 0.0f });
+    transaction.queueEvent(TestPlainEvent{ 10, 0.0f });
+    transaction.queueEmplace<TestPlainEvent>(11, 0.0f);
+    dispatcher.queueEvent(TestPlainEvent{ 2, 0.0f });
+    EXPECT_EQ(transaction.size(), 2u);
+
+    transaction.commit(dispatcher);
+    EXPECT_TRUE(transaction.empty());
+    dispatcher.queueEvent(TestPlainEvent{ 3, 0.0f });
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->ids, (std::vector<int>{ 1, 2, 10, 11, 3 }));
+
+    transaction.queueEvent(TestPlainEvent{ 20, 0.0f });
+    transaction.clear();
+    transaction.commit(dispatcher);
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->ids.size(), 5u);
+}
+
+TEST(EventQueue, CancelledEventsAreSkipped) {
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    auto values = std::make_shared<TestValueListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.subscribeTo<TestValueEvent>(values);
+
+    std::vector<EventQueue::Ticket> tickets;
+    for (int i = 0; i < 2000; ++i)
+        tickets.push_back(dispatcher.queueEvent(TestPlainEvent{ i, 0.0f }));
+    EventQueue::Ticket owned = dispatcher.queueEvent(std::make_unique<TestValueEvent>());
+
+    EXPECT_TRUE(dispatcher.cancel(tickets[0]));
+    EXPECT_FALSE(dispatcher.cancel(tickets[0]));
+    EXPECT_TRUE(dispatcher.cancel(tickets[1999]));
+    EXPECT_TRUE(dispatcher.cancel(owned));
+    EXPECT_EQ(dispatcher.cancelIf<TestPlainEvent>([](const TestPlainEvent& e) { return e.id % 2 == 1; }), 999u);
+    EXPECT_EQ(dispatcher.cancelIf<TestValueEvent>([](const TestValueEvent&) { return true; }), 0u);
+
+    dispatcher.processQueue();
+    ASSERT_EQ(plain->ids.size(), 999u);
+    for (std::size_t i = 0; i < plain->ids.size(); ++i)
+        EXPECT_EQ(plain->ids[i], static_cast<int>(i + 1) * 2);
+    EXPECT_TRUE(values->values.empty());
+
+    EXPECT_FALSE(dispatcher.cancel(tickets[2]));
+    EventQueue::Ticket fresh = dispatcher.queueEvent(TestPlainEvent{ -1, 0.0f });
+    EXPECT_FALSE(dispatcher.cancel(tickets[2]));
+    EXPECT_TRUE(dispatcher.cancel(fresh));
+    dispatcher.processQueue();
+    EXPECT_EQ(plain->ids.size(), 999u);
+}
+
+TEST(EventQueue, EventBeingConsumedCannotBeCancelled) {
+    EventQueue queue;
+    for (int i = 0; i < 3; ++i)
+        queue.emplace<TestPlainEvent>(eventTypeKey<TestPlainEvent>(), TestPlainEvent{ i, 0.0f });
+
+    std::vector<int> ids;
+    std::size_t cancelled = 0;
+    queue.consume([&](EventTypeKey, void* event) {
+        ids.push_back(static_cast<TestPlainEvent*>(event)->id);
+        cancelled += queue.cancelIf([](EventTypeKey, void*) { return true; });
+        EXPECT_EQ(queue.size(), 0u);
+    });
+
+    EXPECT_EQ(ids, (std::vector<int>{ 0 }));
+    EXPECT_EQ(cancelled, 2u);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(EventPriority, HigherPrioritiesAreProcessedFirst) {
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+
+    dispatcher.queueEvent(TestPlainEvent{ 1, 0.0f }, EventPriority::Low);
+    dispatcher.queueEvent(TestPlainEvent{ 2, 0.0f });
+    dispatcher.queueEmplaceWithPriority<TestPlainEvent>(EventPriority::Urgent, 3, 0.0f);
+    dispatcher.queueEvent(TestPlainEvent{ 4, 0.0f }, EventPriority::High);
+    dispatcher.queueEvent(TestPlainEvent{ 5, 0.0f }, EventPriority::Low);
+    EventQueue::Ticket cancelled = dispatcher.queueEvent(TestPlainEvent{ 6, 0.0f }, EventPriority::High);
+    EXPECT_TRUE(dispatcher.cancel(cancelled));
+
+    dispatcher.processQueue();
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 3, 4, 2, 1, 5 }));
+}
+
+class TestEscalatingListener : public EventListener<TestPlainEvent> {
+public:
+    EventDispatcher* dispatcher = nullptr;
+    std::vector<int> ids;
+    void onEvent(const TestPlainEvent& event) override {
+        ids.push_back(event.id);
+        if (event.id == 1)
+            dispatcher->queueEvent(TestPlainEvent{ 100, 0.0f }, EventPriority::Urgent);
+    }
+};
+
+TEST(EventPriority, EventsQueuedWhileProcessingPreemptLowerPriorities) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestEscalatingListener>();
+    listener->dispatcher = &dispatcher;
+    dispatcher.subscribeTo<TestPlainEvent>(listener);
+
+    for (int i = 1; i <= 3; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ i, 0.0f }, EventPriority::Low);
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->ids, (std::vector<int>{ 1, 100, 2, 3 }));
+}
+
+TEST(EventPriority, WeightsPreventStarvation) {
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.setPriorityWeights({ 1, 1, 3, 0 });
+
+    for (int i = 0; i < 6; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ 10 + i, 0.0f }, EventPriority::High);
+    for (int i = 0; i < 2; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ 20 + i, 0.0f });
+    for (int i = 0; i < 2; ++i)
+        dispatcher.queueEvent(TestPlainEvent{ 30 + i, 0.0f }, EventPriority::Low);
+    dispatcher.queueEvent(TestPlainEvent{ 40, 0.0f }, EventPriority::Urgent);
+
+    dispatcher.processQueue();
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 40, 10, 11, 12, 20, 30, 13, 14, 15, 21, 31 }));
+}
+
+TEST(EventDeadline, ExpiredEventsAreDroppedAndCounted) {
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    auto values = std::make_shared<TestValueListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.subscribeTo<TestValueEvent>(values);
+
+    auto now = std::chrono::steady_clock::now();
+    dispatcher.queueEventUntil(TestPlainEvent{ 1, 0.0f }, now - std::chrono::seconds(1));
+    dispatcher.queueEventUntil(TestPlainEvent{ 2, 0.0f }, now + std::chrono::hours(1));
+    dispatcher.queueEventFor(TestPlainEvent{ 3, 0.0f }, std::chrono::milliseconds(-1), EventPriority::High);
+    dispatcher.queueEventFor(TestPlainEvent{ 4, 0.0f }, std::chrono::minutes(1), EventPriority::Low);
+    TestValueEvent stale;
+    stale.value = 5;
+    dispatcher.queueEventUntil(stale, now - std::chrono::seconds(1));
+    dispatcher.queueEvent(TestPlainEvent{ 6, 0.0f });
+
+    dispatcher.processQueue();
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 2, 6, 4 }));
+    EXPECT_TRUE(values->values.empty());
+    EXPECT_EQ(dispatcher.expiredCount<TestPlainEvent>(), 2u);
+    EXPECT_EQ(dispatcher.expiredCount<TestValueEvent>(), 1u);
+    EXPECT_EQ(dispatcher.expiredCount<TestEventA>(), 0u);
+}
+
+class TestBatchListener : public BatchListener<TestPlainEvent> {
+public:
+    std::vector<std::vector<int>> batches;
+    std::size_t delivered = 0;
+    bool record = true;
+    void onBatch(std::span<const TestPlainEvent> events) override {
+        delivered += events.size();
+        if (!record)
+            return;
+        std::vector<int> ids;
+        for (const TestPlainEvent& event : events)
+            ids.push_back(event.id);
+        batches.push_back(ids);
+    }
+};
+
+TEST(EventBatch, DeliversFullWindowsAndFlushesRemainder) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestBatchListener>();
+    dispatcher.subscribeBatchTo<TestPlainEvent>(listener, 3);
+
+    for (int i = 0; i < 7; ++i)
+        dispatcher.dispatch(TestPlainEvent{ i, 0.0f });
+    EXPECT_EQ(listener->batches, (std::vector<std::vector<int>>{ { 0, 1, 2 }, { 3, 4, 5 } }));
+
+    dispatcher.flushBatches();
+    EXPECT_EQ(listener->batches.size(), 3u);
+    EXPECT_EQ(listener->batches.back(), (std::vector<int>{ 6 }));
+
+    dispatcher.queueEvent(TestPlainEvent{ 7, 0.0f });
+    dispatcher.processQueue();
+    dispatcher.unsubscribeBatchFrom<TestPlainEvent>(listener);
+    EXPECT_EQ(listener->batches.back(), (std::vector<int>{ 7 }));
+
+    dispatcher.dispatch(TestPlainEvent{ 8, 0.0f });
+    dispatcher.flushBatches();
+    EXPECT_EQ(listener->batches.size(), 4u);
+}
+
+TEST(EventBatch, WindowsCloseAfterDelay) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestBatchListener>();
+    dispatcher.subscribeBatchTo<TestPlainEvent>(listener, 100, std::chrono::milliseconds(5));
+
+    dispatcher.dispatch(TestPlainEvent{ 1, 0.0f });
+    dispatcher.pollBatches();
+    EXPECT_TRUE(listener->batches.empty());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->batches, (std::vector<std::vector<int>>{ { 1 } }));
+}
+
+TEST(EventBatch, BuffersAreReusedAcrossWindows) {
+    EventDispatcher dispatcher;
+    auto listener = std::make_shared<TestBatchListener>();
+    listener->record = false;
+    dispatcher.subscribeBatchTo<TestPlainEvent>(listener, 16);
+    for (int i = 0; i < 32; ++i)
+        dispatcher.dispatch(TestPlainEvent{ i, 0.0f });
+
+    std::size_t allocations = 0;
+    {
+        AllocationGuard guard;
+        for (int i = 0; i < 1600; ++i)
+            dispatcher.dispatch(TestPlainEvent{ i, 0.0f });
+        allocations = guard.allocations();
+    }
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(listener->delivered, 1632u);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+struct TestNamedEvent {
+    std::string name;
+};
+
+template <>
+struct EventCodec<TestNamedEvent> {
+    static void encode(const TestNamedEvent& event, std::vector<std::byte>& out) {
+        const std::byte* bytes = reinterpret_cast<const std::byte*>(event.name.data());
+        out.insert(out.end(), bytes, bytes + event.name.size());
+    }
+
+    static std::optional<TestNamedEvent> decode(std::span<const std::byte> bytes) {
+        return TestNamedEvent{ std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size()) };
+    }
+};
+
+class TestNamedListener : public EventListener<TestNamedEvent> {
+public:
+    std::vector<std::string> names;
+    void onEvent(const TestNamedEvent& event) override { names.push_back(event.name); }
+};
+
+static std::string testLogPath(const char* name) {
+    std::string path = ::testing::TempDir() + name;
+    std::remove(path.c_str());
+    std::remove((path + ".ack").c_str());
+    return path;
+}
+
+TEST(EventSerialization, TypeIdsAreStableAndDistinct) {
+    static_assert(eventTypeId<TestPlainEvent>() == fnv1a("TestPlainEvent"));
+    static_assert(eventTypeId<TestPlainEvent>() != eventTypeId<TestNamedEvent>());
+    static_assert(SerializableEvent<TestPlainEvent>);
+    static_assert(SerializableEvent<TestNamedEvent>);
+    static_assert(!SerializableEvent<TestValueEvent>);
+
+    std::vector<std::byte> bytes;
+    EventCodec<TestPlainEvent>::encode(TestPlainEvent{ 3, 1.5f }, bytes);
+    auto decoded = EventCodec<TestPlainEvent>::decode(bytes);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->id, 3);
+    EXPECT_EQ(decoded->value, 1.5f);
+    EXPECT_FALSE(EventCodec<TestPlainEvent>::decode(std::span(bytes).first(2)).has_value());
+}
+
+TEST(DurableEventQueue, ResumesAfterRestart) {
+    std::string path = testLogPath("marschall-resume.wal");
+    {
+        DurableEventQueue queue;
+        ASSERT_TRUE(queue.open(path));
+        EXPECT_TRUE(queue.queueEvent(TestPlainEvent{ 1, 0.0f }));
+        EXPECT_TRUE(queue.queueEvent(TestNamedEvent{ "audit" }));
+        EXPECT_TRUE(queue.queueEvent(TestPlainEvent{ 2, 0.0f }));
+    }
+
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    auto named = std::make_shared<TestNamedListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.subscribeTo<TestNamedEvent>(named);
+    {
+        DurableEventQueue queue;
+        ASSERT_TRUE(queue.open(path));
+        queue.registerType<TestPlainEvent>();
+        EXPECT_EQ(queue.processQueue(dispatcher), 1u);
+        EXPECT_GT(queue.backlog(), 0u);
+
+        queue.registerType<TestNamedEvent>();
+        EXPECT_EQ(queue.processQueue(dispatcher), 2u);
+        EXPECT_EQ(queue.backlog(), 0u);
+    }
+    {
+        DurableEventQueue queue;
+        ASSERT_TRUE(queue.open(path));
+        queue.registerType<TestPlainEvent>();
+        queue.registerType<TestNamedEvent>();
+        EXPECT_EQ(queue.processQueue(dispatcher), 0u);
+    }
+
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 1, 2 }));
+    EXPECT_EQ(named->names, (std::vector<std::string>{ "audit" }));
+}
+
+TEST(DurableEventQueue, DiscardsTornRecord) {
+    std::string path = testLogPath("marschall-torn.wal");
+    {
+        DurableEventQueue queue;
+        ASSERT_TRUE(queue.open(path));
+        EXPECT_TRUE(queue.queueEvent(TestPlainEvent{ 1, 0.0f }));
+    }
+    {
+        std::FILE* file = std::fopen(path.c_str(), "ab");
+        ASSERT_NE(file, nullptr);
+        const char torn[] = { 8, 0, 0, 0, 1, 2, 3, 4, 5 };
+        std::fwrite(torn, 1, sizeof(torn), file);
+        std::fclose(file);
+    }
+
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+
+    DurableEventQueue queue;
+    ASSERT_TRUE(queue.open(path));
+    EXPECT_TRUE(queue.queueEvent(TestPlainEvent{ 2, 0.0f }));
+    EXPECT_EQ(queue.processQueue(dispatcher), 2u);
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 1, 2 }));
+}
+
+TEST(DurableEventQueue, GroupCommitsConcurrentWriters) {
+    std::string path = testLogPath("marschall-group.wal");
+    DurableEventQueue queue;
+    ASSERT_TRUE(queue.open(path, 0));
+
+    constexpr int threadCount = 4;
+    constexpr int perThread = 50;
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&queue, &failures, t] {
+            for (int i = 0; i < perThread; ++i)
+                if (!queue.queueEvent(TestPlainEvent{ t * perThread + i, 0.0f }))
+                    ++failures;
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(failures.load(), 0);
+
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    EXPECT_EQ(queue.processQueue(dispatcher), static_cast<std::size_t>(threadCount * perThread));
+    EXPECT_EQ(queue.backlog(), 0u);
+
+    std::sort(plain->ids.begin(), plain->ids.end());
+    for (int i = 0; i < threadCount * perThread; ++i)
+        EXPECT_EQ(plain->ids[i], i);
+
+    EXPECT_TRUE(queue.queueEvent(TestPlainEvent{ -1, 0.0f }));
+    EXPECT_EQ(queue.processQueue(dispatcher), 1u);
+    EXPECT_EQ(plain->ids.back(), -1);
+}
+TEST(MappedEventSpill, ReadsRecordsBackInOrderAcrossSegments) {
+    MappedEventSpill spill(::testing::TempDir(), 64);
+    for (int i = 0; i < 100; ++i) {
+        std::vector<std::byte> record(static_cast<std::size_t>(i % 13 + 1), static_cast<std::byte>(i));
+        ASSERT_TRUE(spill.write(record));
+    }
+    EXPECT_EQ(spill.size(), 100u);
+    EXPECT_GT(spill.segmentCount(), 1u);
+
+    for (int i = 0; i < 100; ++i) {
+        std::span<const std::byte> record = spill.read();
+        ASSERT_EQ(record.size(), static_cast<std::size_t>(i % 13 + 1));
+        EXPECT_EQ(record.front(), static_cast<std::byte>(i));
+        EXPECT_EQ(record.back(), static_cast<std::byte>(i));
+    }
+    EXPECT_TRUE(spill.read().empty());
+    EXPECT_EQ(spill.size(), 0u);
+    EXPECT_EQ(spill.segmentCount(), 1u);
+}
+
+class TestSequenceListener : public MultiEventListener<TestPlainEvent, TestValueEvent> {
+public:
+    std::vector<int> sequence;
+    void onEvent(const TestPlainEvent& event) override { sequence.push_back(event.id); }
+    void onEvent(const TestValueEvent& event) override { sequence.push_back(-event.value); }
+};
+
+TEST(EventDispatcher, SpillsQueuedEventsBeyondBudgetInOrder) {
+    EventDispatcher dispatcher;
+    auto spill = std::make_shared<MappedEventSpill>(::testing::TempDir(), 4096);
+    dispatcher.setSpill(spill, 1024);
+
+    auto listener = std::make_shared<TestSequenceListener>();
+    dispatcher.subscribeTo<TestPlainEvent, TestValueEvent>(listener);
+
+    std::vector<int> expected;
+    for (int i = 1; i <= 2000; ++i) {
+        if (i % 100 == 0) {
+            auto event = std::make_unique<TestValueEvent>();
+            event->value = i;
+            dispatcher.queueEvent(std::move(event));
+            expected.push_back(-i);
+        } else {
+            dispatcher.queueEvent(TestPlainEvent{ i, 0.0f });
+            expected.push_back(i);
+        }
+    }
+    EXPECT_GT(spill->size(), 1000u);
+    EXPECT_GT(spill->segmentCount(), 1u);
+
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->sequence, expected);
+    EXPECT_EQ(spill->size(), 0u);
+
+    listener->sequence.clear();
+    dispatcher.queueEvent(TestPlainEvent{ 1, 0.0f });
+    EXPECT_EQ(spill->size(), 0u);
+    dispatcher.processQueue();
+    EXPECT_EQ(listener->sequence, (std::vector<int>{ 1 }));
+}
+TEST(EventBridge, ForwardsEventsBetweenProcesses) {
+    int sockets[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+    pid_t child = ::fork();
+    ASSERT_NE(child, -1);
+    if (child == 0) {
+        ::close(sockets[0]);
+        EventDispatcher dispatcher;
+        {
+            EventBridgeSender sender(sockets[1], 256, std::chrono::seconds(10));
+            sender.forward<TestPlainEvent, TestNamedEvent>(dispatcher);
+            for (int i = 0; i < 1000; ++i)
+                dispatcher.dispatch(TestPlainEvent{ i, 0.0f });
+            dispatcher.dispatch(TestNamedEvent{ "done" });
+        }
+        ::_exit(0);
+    }
+    ::close(sockets[1]);
+
+    EventDispatcher dispatcher;
+    auto plain = std::make_shared<TestPlainListener>();
+    auto named = std::make_shared<TestNamedListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    dispatcher.subscribeTo<TestNamedEvent>(named);
+
+    EventBridgeReceiver receiver(sockets[0]);
+    receiver.accept<TestPlainEvent, TestNamedEvent>();
+    std::size_t received = 0;
+    while (receiver.isOpen())
+        received += receiver.receive(dispatcher, 1000);
+
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(received, 1001u);
+    ASSERT_EQ(plain->ids.size(), 1000u);
+    for (int i = 0; i < 1000; ++i)
+        EXPECT_EQ(plain->ids[i], i);
+    EXPECT_EQ(named->names, (std::vector<std::string>{ "done" }));
+}
+
+TEST(EventBridge, BatchesBySizeAndLatency) {
+    int sockets[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+    EventBridgeSender sender(sockets[0], 1024, std::chrono::milliseconds(5));
+    EventBridgeReceiver receiver(sockets[1]);
+    receiver.accept<TestPlainEvent>();
+
+    EventDispatcher source;
+    EventDispatcher target;
+    sender.forward<TestPlainEvent>(source);
+    auto plain = std::make_shared<TestPlainListener>();
+    target.subscribeTo<TestPlainEvent>(plain);
+
+    source.dispatch(TestPlainEvent{ 1, 0.0f });
+    EXPECT_EQ(sender.framesSent(), 0u);
+    EXPECT_EQ(receiver.receive(target), 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_TRUE(sender.poll());
+    EXPECT_EQ(sender.framesSent(), 1u);
+    EXPECT_EQ(receiver.receive(target, 1000), 1u);
+
+    for (int i = 0; i < 200; ++i)
+        source.dispatch(TestPlainEvent{ i, 0.0f });
+    EXPECT_GE(sender.framesSent(), 3u);
+    EXPECT_TRUE(sender.flush());
+
+    std::size_t received = 0;
+    while (received < 200)
+        received += receiver.receive(target, 1000);
+    EXPECT_EQ(plain->ids.size(), 201u);
+    EXPECT_EQ(receiver.skipped(), 0u);
+}
+
+TEST(EventBridge, ReceiverLimitsReadsAndFrameSize) {
+    int sockets[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets), 0);
+
+    EventBridgeSender sender(sockets[0], std::size_t{ 64 } << 10, std::chrono::seconds(10));
+    EventBridgeReceiver receiver(sockets[1], 1024 * 1024, 4096);
+    receiver.accept<TestPlainEvent>();
+
+    EventDispatcher source;
+    EventDispatcher target;
+    sender.forward<TestPlainEvent>(source);
+    auto plain = std::make_shared<TestPlainListener>();
+    target.subscribeTo<TestPlainEvent>(plain);
+
+    for (int i = 0; i < 1000; ++i)
+        source.dispatch(TestPlainEvent{ i, 0.0f });
+    EXPECT_TRUE(sender.flush());
+    EXPECT_EQ(sender.framesSent(), 1u);
+
+    // The frame is larger than a single receive call may read.
+    EXPECT_EQ(receiver.receive(target, 1000), 0u);
+    std::size_t received = 0;
+    while (received < 1000 && receiver.isOpen())
+        received += receiver.receive(target, 1000);
+    EXPECT_EQ(plain->ids.size(), 1000u);
+
+    int raw[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, raw), 0);
+    EventBridgeReceiver limited(raw[1], 1024);
+    EventBridgeFrame frame{ 2048, 1 };
+    ASSERT_EQ(::send(raw[0], &frame, sizeof(frame), 0), static_cast<ssize_t>(sizeof(frame)));
+    EXPECT_EQ(limited.receive(target, 1000), 0u);
+    EXPECT_FALSE(limited.isOpen());
+    ::close(raw[0]);
+}
+#endif
+
+#if defined(__linux__)
+class TestFileReadyListener : public EventListener<FileReadyEvent> {
+public:
+    std::vector<int> fds;
+    void onEvent(const FileReadyEvent& event) override { fds.push_back(event.fd); }
+};
+
+TEST(EventLoop, WakesForEventsQueuedFromOtherThreads) {
+    EventDispatcher dispatcher;
+    EventLoop loop(dispatcher);
+    ASSERT_TRUE(loop.isOpen());
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+
+    EXPECT_EQ(loop.waitAndProcess(0), 0u);
+
+    std::thread producer([&loop] {
+        for (int i = 0; i < 100; ++i)
+            loop.queueEvent(TestPlainEvent{ i, 0.0f });
+    });
+    while (plain->ids.size() < 100)
+        loop.waitAndProcess(1000);
+    producer.join();
+
+    for (int i = 0; i < 100; ++i)
+        EXPECT_EQ(plain->ids[i], i);
+    EXPECT_EQ(loop.waitAndProcess(0), 0u);
+}
+
+TEST(EventLoop, DispatchesReadinessOfWatchedDescriptors) {
+    EventDispatcher dispatcher;
+    EventLoop loop(dispatcher);
+    auto ready = std::make_shared<TestFileReadyListener>();
+    dispatcher.subscribeTo<FileReadyEvent>(ready);
+
+    int pipe[2];
+    ASSERT_EQ(::pipe(pipe), 0);
+    ASSERT_TRUE(loop.watch(pipe[0]));
+
+    EXPECT_EQ(loop.waitAndProcess(0), 0u);
+    ASSERT_EQ(::write(pipe[1], "x", 1), 1);
+    EXPECT_EQ(loop.waitAndProcess(1000), 1u);
+    EXPECT_EQ(ready->fds, (std::vector<int>{ pipe[0] }));
+
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+    ASSERT_TRUE(loop.watch(pipe[0], EPOLLIN, [](EventDispatcher& dispatcher, int fd, std::uint32_t) {
+        char byte;
+        if (::read(fd, &byte, 1) == 1)
+            dispatcher.queueEvent(TestPlainEvent{ byte, 0.0f });
+    }));
+    EXPECT_EQ(loop.waitAndProcess(1000), 1u);
+    EXPECT_EQ(plain->ids, (std::vector<int>{ 'x' }));
+
+    loop.unwatch(pipe[0]);
+    ASSERT_EQ(::write(pipe[1], "y", 1), 1);
+    EXPECT_EQ(loop.waitAndProcess(0), 0u);
+    ::close(pipe[0]);
+    ::close(pipe[1]);
+}
+
+TEST(EventLoop, TransactionsFromOtherThreadsArriveWhole) {
+    EventDispatcher dispatcher;
+    EventLoop loop(dispatcher);
+    auto plain = std::make_shared<TestPlainListener>();
+    dispatcher.subscribeTo<TestPlainEvent>(plain);
+
+    constexpr int producerCount = 4;
+    constexpr int perProducer = 200;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p) {
+        producers.emplace_back([&loop, p] {
+            EventTransaction transaction;
+            for (int i = 0; i < perProducer; ++i) {
+                int id = (p * perProducer + i) * 2;
+                transaction.queueEvent(TestPlainEvent{ id, 0.0f });
+                transaction.queueEvent(TestPlainEvent{ id + 1, 0.0f });
+                transaction.commit(loop);
+            }
+        });
+    }
+    while (plain->ids.size() < static_cast<std::size_t>(producerCount * perProducer * 2))
+        loop.waitAndProcess(1000);
+    for (auto& producer : producers)
+        producer.join();
+
+    for (std::size_t i = 0; i < plain->ids.size(); i += 2) {
+        EXPECT_EQ(plain->ids[i] % 2, 0);
+        EXPECT_EQ(plain->ids[i + 1], plain->ids[i] + 1);
+    }
+}
+#endif
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -0,0 +1,423 @@
+#pragma once
+#include "EventDispatcher.hpp"
+#include "EventSerialization.hpp"
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <span>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+ * Write-ahead log of serialized events that survive crashes and restarts.
+ *
+ * queueEvent returns once the event is durable on disk. Concurrent callers share syncs: while one thread writes
+ * and syncs, events queued by the others are buffered and committed together by the next sync (group commit).
+ * processQueue dispatches the logged events in order and records how far it got, so after a restart processing
+ * resumes after the last acknowledged event.
+ *
+ * @remarks Delivery is at least once, events being processed when the process dies are delivered again.
+ *          Requires POSIX file APIs. processQueue must not be called concurrently with itself.
+ */
+class DurableEventQueue
+{
+public:
+	/// Bytes read from the log at once while processing.
+	static constexpr std::size_t readWindow = 1 << 20;
+
+	DurableEventQueue() = default;
+	DurableEventQueue(const DurableEventQueue&) = delete;
+	DurableEventQueue& operator=(const DurableEventQueue&) = delete;
+
+	~DurableEventQueue()
+	{
+		close();
+	}
+
+	/*
+	 * Open or create the log.
+	 *
+	 * A record torn by a crash while it was written is discarded.
+	 *
+	 * @param path Path of the log file, the acknowledged offset is kept next to it with the suffix ".ack".
+	 * @param compactionThreshold Size in bytes above which a fully acknowledged log is truncated.
+	 * @return False if the files could not be opened.
+	 */
+	bool open(const std::string& path, std::uint64_t compactionThreshold = std::uint64_t{ 64 } << 20)
+	{
+		close();
+
+		std::lock_guard lock(mutex);
+		logFile = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		ackFile = ::open((path + ".ack").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+		if (logFile == -1 || ackFile == -1 || !recover())
+		{
+			closeFiles();
+			return false;
+		}
+
+		threshold = compactionThreshold;
+		failed = false;
+		return true;
+	}
+
+	/// Close the log, events not yet processed are kept for the next time it is opened.
+	void close() noexcept
+	{
+		std::unique_lock lock(mutex);
+		synced.wait(lock, [this] { return !flushing; });
+		closeFiles();
+	}
+
+	bool isOpen() const noexcept
+	{
+		std::lock_guard lock(mutex);
+		return logFile != -1;
+	}
+
+	/*
+	 * Register an event type for processing.
+	 *
+	 * Types are registered when events of them are queued. After a restart, types of logged events must be
+	 * registered before processQueue can dispatch them.
+	 *
+	 * @tparam EType The event type.
+	 */
+	template <SerializableEvent EType>
+	void registerType()
+	{
+		std::lock_guard lock(mutex);
+		decoders.try_emplace(eventTypeId<EType>(), &replay<EType>);
+	}
+
+	/*
+	 * Append an event to the log and wait until it is durable.
+	 *
+	 * @tparam EType The event type.
+	 * @param event The event to queue.
+	 * @return False if the log is not open or could not be written, in which case the event may be lost.
+	 */
+	template <SerializableEvent EType>
+	bool queueEvent(const EType& event)
+	{
+		std::unique_lock lock(mutex);
+		if (logFile == -1 || failed)
+			return false;
+
+		decoders.try_emplace(eventTypeId<EType>(), &replay<EType>);
+
+		std::size_t start = pending.size();
+		pending.resize(start + sizeof(RecordHeader));
+		EventCodec<EType>::encode(event, pending);
+
+		std::span<const std::byte> payload = std::span<const std::byte>(pending).subspan(start + sizeof(RecordHeader));
+		RecordHeader header{ static_cast<std::uint32_t>(payload.size()), 0, eventTypeId<EType>() };
+		header.checksum = checksum(header.type, payload);
+		std::memcpy(pending.data() + start, &header, sizeof(header));
+
+		appended += sizeof(RecordHeader) + payload.size();
+		return commit(lock, appended);
+	}
+
+	/*
+	 * Dispatch all durable events that were not acknowledged yet, then acknowledge them.
+	 *
+	 * Events queued by listeners are processed in the same call. Processing stops before an event of an
+	 * unregistered type, which stays in the log.
+	 *
+	 * @param dispatcher The dispatcher to dispatch the events with, events are moved into consumers.
+	 * @return The number of events dispatched.
+	 */
+	std::size_t processQueue(EventDispatcher& dispatcher)
+	{
+		std::size_t processed = 0;
+		EventTypeId lastType = 0;
+		Decoder lastDecoder = nullptr;
+
+		for (;;)
+		{
+			std::uint64_t end;
+			{
+				std::lock_guard lock(mutex);
+				if (logFile == -1)
+					return processed;
+				end = durableEnd;
+			}
+			if (ackOffset == end)
+				return processed;
+
+			std::uint64_t offset = ackOffset;
+			std::size_t window = readWindow;
+			bool blocked = false;
+			while (offset < end && !blocked)
+			{
+				std::size_t length = static_cast<std::size_t>(std::min<std::uint64_t>(end - offset, window));
+				readBuffer.resize(length);
+				if (!readAll(logFile, readBuffer.data(), length, offset))
+					return processed;
+
+				std::size_t position = 0;
+				while (position + sizeof(RecordHeader) <= length)
+				{
+					RecordHeader header;
+					std::memcpy(&header, readBuffer.data() + position, sizeof(header));
+					std::size_t recordSize = sizeof(RecordHeader) + header.size;
+					if (position + recordSize > length)
+					{
+						if (position == 0)
+							window = recordSize;
+						break;
+					}
+
+					if (header.type != lastType || !lastDecoder)
+					{
+						lastType = header.type;
+						lastDecoder = findDecoder(header.type);
+					}
+
+					std::span<const std::byte> payload(readBuffer.data() + position + sizeof(RecordHeader), header.size);
+					if (!lastDecoder || !lastDecoder(payload, dispatcher))
+					{
+						blocked = true;
+						break;
+					}
+
+					position += recordSize;
+					++processed;
+				}
+				offset += position;
+			}
+
+			acknowledge(offset);
+			if (blocked)
+				return processed;
+		}
+	}
+
+	/// Number of durable bytes not acknowledged yet.
+	std::uint64_t backlog() const
+	{
+		std::lock_guard lock(mutex);
+		return durableEnd - ackOffset;
+	}
+
+private:
+	using Decoder = bool (*)(std::span<const std::byte>, EventDispatcher&);
+
+	/// Header preceding each serialized event in the log.
+	struct RecordHeader
+	{
+		std::uint32_t size;
+		std::uint32_t checksum;
+		EventTypeId type;
+	};
+
+	template <SerializableEvent EType>
+	static bool replay(std::span<const std::byte> payload, EventDispatcher& dispatcher)
+	{
+		std::optional<EType> event = EventCodec<EType>::decode(payload);
+		if (!event)
+			return false;
+
+		dispatcher.dispatch(std::move(*event));
+		return true;
+	}
+
+	static std::uint32_t checksum(EventTypeId type, std::span<const std::byte> payload) noexcept
+	{
+		std::uint64_t hash = fnv1a(payload, type);
+		return static_cast<std::uint32_t>(hash ^ (hash >> 32));
+	}
+
+	static bool writeAll(int file, const std::byte* data, std::size_t size, std::uint64_t offset) noexcept
+	{
+		while (size != 0)
+		{
+			ssize_t written = ::pwrite(file, data, size, static_cast<off_t>(offset));
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return false;
+			data += written;
+			size -= static_cast<std::size_t>(written);
+			offset += static_cast<std::uint64_t>(written);
+		}
+		return true;
+	}
+
+	static bool readAll(int file, std::byte* data, std::size_t size, std::uint64_t offset) noexcept
+	{
+		while (size != 0)
+		{
+			ssize_t read = ::pread(file, data, size, static_cast<off_t>(offset));
+			if (read < 0 && errno == EINTR)
+				continue;
+			if (read <= 0)
+				return false;
+			data += read;
+			size -= static_cast<std::size_t>(read);
+			offset += static_cast<std::uint64_t>(read);
+		}
+		return true;
+	}
+
+	static bool sync(int file) noexcept
+	{
+#if defined(__APPLE__)
+		return ::fsync(file) == 0;
+#else
+		return ::fdatasync(file) == 0;
+#endif
+	}
+
+	/*
+	 * Wait until a number of appended bytes is durable, syncing the log if no other thread does.
+	 *
+	 * The thread that syncs takes all buffered records with it, records buffered meanwhile are
+	 * committed by the next sync.
+	 */
+	bool commit(std::unique_lock<std::mutex>& lock, std::uint64_t target)
+	{
+		while (committed < target)
+		{
+			if (failed)
+				return false;
+
+			if (flushing)
+			{
+				synced.wait(lock);
+				continue;
+			}
+
+			flushing = true;
+			std::swap(pending, writing);
+			std::uint64_t offset = pendingOffset;
+			pendingOffset += writing.size();
+
+			lock.unlock();
+			bool written = writeAll(logFile, writing.data(), writing.size(), offset) && sync(logFile);
+			lock.lock();
+
+			if (written)
+			{
+				durableEnd = offset + writing.size();
+				committed += writing.size();
+			}
+			else
+				failed = true;
+			writing.clear();
+			flushing = false;
+			synced.notify_all();
+		}
+		return true;
+	}
+
+	Decoder findDecoder(EventTypeId type)
+	{
+		std::lock_guard lock(mutex);
+		auto it = decoders.find(type);
+		return it != decoders.end() ? it->second : nullptr;
+	}
+
+	/*
+	 * Persist the offset up to which events were processed.
+	 *
+	 * Once everything is acknowledged and the log exceeds the compaction threshold, it is truncated.
+	 */
+	void acknowledge(std::uint64_t offset)
+	{
+		std::lock_guard lock(mutex);
+		ackOffset = offset;
+
+		if (ackOffset == durableEnd && pending.empty() && !flushing && ackOffset >= threshold)
+		{
+			if (::ftruncate(logFile, 0) == 0 && sync(logFile))
+				ackOffset = durableEnd = pendingOffset = 0;
+		}
+
+		std::uint64_t value = ackOffset;
+		if (writeAll(ackFile, reinterpret_cast<const std::byte*>(&value), sizeof(value), 0))
+			sync(ackFile);
+	}
+
+	/// Restore the acknowledged offset and drop a torn record at the end of the log.
+	bool recover()
+	{
+		struct stat status;
+		if (::fstat(logFile, &status) != 0)
+			return false;
+		std::uint64_t size = static_cast<std::uint64_t>(status.st_size);
+
+		std::uint64_t acknowledged = 0;
+		if (!readAll(ackFile, reinterpret_cast<std::byte*>(&acknowledged), sizeof(acknowledged), 0))
+			acknowledged = 0;
+		acknowledged = std::min(acknowledged, size);
+
+		std::uint64_t offset = acknowledged;
+		while (offset + sizeof(RecordHeader) <= size)
+		{
+			RecordHeader header;
+			if (!readAll(logFile, reinterpret_cast<std::byte*>(&header), sizeof(header), offset))
+				return false;
+			if (offset + sizeof(RecordHeader) + header.size > size)
+				break;
+
+			readBuffer.resize(header.size);
+			if (!readAll(logFile, readBuffer.data(), header.size, offset + sizeof(RecordHeader)))
+				return false;
+			if (checksum(header.type, readBuffer) != header.checksum)
+				break;
+
+			offset += sizeof(RecordHeader) + header.size;
+		}
+
+		if (offset != size && (::ftruncate(logFile, static_cast<off_t>(offset)) != 0 || !sync(logFile)))
+			return false;
+
+		ackOffset = acknowledged;
+		durableEnd = pendingOffset = offset;
+		return true;
+	}
+
+	void closeFiles() noexcept
+	{
+		if (logFile != -1)
+			::close(logFile);
+		if (ackFile != -1)
+			::close(ackFile);
+		logFile = ackFile = -1;
+		pending.clear();
+		ackOffset = durableEnd = pendingOffset = 0;
+		appended = committed = 0;
+	}
+
+	mutable std::mutex mutex;
+	std::condition_variable synced;
+	int logFile = -1;
+	int ackFile = -1;
+	std::unordered_map<EventTypeId, Decoder> decoders;
+
+	/// Records waiting for the next sync, starting at pendingOffset.
+	std::vector<std::byte> pending;
+	/// Records being written by the syncing thread.
+	std::vector<std::byte> writing;
+	std::uint64_t pendingOffset = 0;
+	std::uint64_t durableEnd = 0;
+	/// Total bytes ever buffered and synced, unaffected by compaction.
+	std::uint64_t appended = 0;
+	std::uint64_t committed = 0;
+	bool flushing = false;
+	bool failed = false;
+
+	std::uint64_t ackOffset = 0;
+	std::uint64_t threshold = 0;
+	std::vector<std::byte> readBuffer;
+};
@@ -1,29 +1,130 @@
 #pragma once
 #include <type_traits>
+#include <string_view>
+#include <memory>
 
 
 /// Unique key type for each event type
 using EventTypeKey = const void*;
 
 /*
- * Abstract base class all events must inherit from.
+ * Base class for polymorphic events.
  *
+ * Events deriving from Event can be dispatched and queued through a reference or pointer to Event.
+ * Events that are only dispatched by their concrete type don't need to inherit from it, which keeps
+ * them free of a vtable so they can be trivially copyable.
  */
 class Event
 {
 public:
 	virtual ~Event() = default;
+
+	/// Key of the concrete event type, nullptr unless the event derives from EventBase.
+	virtual EventTypeKey getTypeKey() const noexcept
+	{
+		return nullptr;
+	}
+
+	/// Name of the concrete event type, empty unless the event derives from EventBase.
+	virtual std::string_view getTypeName() const noexcept
+	{
+		return {};
+	}
 };
 
 
-/// Concept to ensure a type is derived from Event
+/// Whether a type is a smart pointer, which is queued through the event it points to rather than as an event.
+template<class T>
+inline constexpr bool isSmartPointer = false;
+
+template<class T, class Deleter>
+inline constexpr bool isSmartPointer<std::unique_ptr<T, Deleter>> = true;
+
+template<class T>
+inline constexpr bool isSmartPointer<std::shared_ptr<T>> = true;
+
+template<class T>
+inline constexpr bool isSmartPointer<std::weak_ptr<T>> = true;
+
+/// Concept for event types, any non-const class type except smart pointers can be an event
 template<class T>
-concept EventType = std::is_convertible_v<T*, Event*>;
+concept EventType = std::is_class_v<T> && !std::is_const_v<T> && !std::is_volatile_v<T> && !isSmartPointer<T>;
+
+/// Concept to ensure an event type is derived from Event
+template<class T>
+concept PolymorphicEventType = EventType<T> && std::is_convertible_v<T*, Event*>;
+
+/// Concept for events that query listeners for a result of type T::Result
+template<class T>
+concept QueryType = EventType<T> && requires { typename T::Result; };
+
+/// One variable per type, its address serves as the type's key. Not const so it can't be merged with others.
+template<class T>
+inline char eventTypeTag = 0;
+
+/*
+ * Get the unique key of an event type.
+ *
+ * Keys are resolved at compile time and don't rely on RTTI.
+ *
+ * @tparam T The event type.
+ */
+template<class T>
+constexpr EventTypeKey eventTypeKey() noexcept
+{
+	return &eventTypeTag<T>;
+}
+
+/*
+ * Get the name of a type at compile time, for diagnostics and tracing.
+ *
+ * The name is extracted from the compiler's function signature string and doesn't rely on RTTI.
+ *
+ * @tparam T The type.
+ */
+template<class T>
+constexpr std::string_view eventTypeName() noexcept
+{
+#if defined(__clang__) || defined(__GNUC__)
+	constexpr std::string_view signature = __PRETTY_FUNCTION__;
+	constexpr std::string_view prefix = "T = ";
+	constexpr std::size_t first = signature.find(prefix) + prefix.size();
+	constexpr std::size_t last = signature.find_first_of(";]", first);
+	return signature.substr(first, last - first);
+#elif defined(_MSC_VER)
+	constexpr std::string_view signature = __FUNCSIG__;
+	constexpr std::string_view prefix = "eventTypeName<";
+	std::size_t first = signature.find(prefix) + prefix.size();
+	std::size_t last = signature.rfind(">(void)");
+	std::string_view name = signature.substr(first, last - first);
+	for (std::string_view keyword : { std::string_view("struct "), std::string_view("class "), std::string_view("enum ") })
+		if (name.starts_with(keyword))
+			name.remove_prefix(keyword.size());
+	return name;
+#else
+	return {};
+#endif
+}
 
 /*
  * Base class for events to inherit from.
  * 
  * Implements the getTypeKey method using CRTP to provide a unique type key for each event type.
+ * Events dispatched or queued through a reference or pointer to Event must derive from it.
  * 
  * @tparam EType The event type.
- */
\ No newline at end of file
+ */
+template<class EType>
+class EventBase : public Event
+{
+public:
+	EventTypeKey getTypeKey() const noexcept override
+	{
+		return eventTypeKey<EType>();
+	}
+
+	std::string_view getTypeName() const noexcept override
+	{
+		return eventTypeName<EType>();
+	}
+};
\ No newline at end of file
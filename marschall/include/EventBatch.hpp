@@ -0,0 +1,138 @@
+#pragma once
+#include "Event.hpp"
+#include "EventListener.hpp"
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstddef>
+
+/*
+ * Type-erased interface for event batches.
+ *
+ * Lets the dispatcher close the windows of batches of all types.
+ */
+class IEventBatch
+{
+public:
+	virtual ~IEventBatch() = default;
+
+	/*
+	 * Deliver the collected events if the window is over.
+	 *
+	 * @param force Whether to deliver regardless of the window.
+	 * @return False if the listener expired.
+	 */
+	virtual bool flush(bool force) = 0;
+	virtual bool expired() const noexcept = 0;
+	virtual EventTypeKey type() const noexcept = 0;
+	virtual const IEventListener* listener() const noexcept = 0;
+	/// Bytes allocated by the batch's buffers.
+	virtual std::size_t memoryUsage() const noexcept = 0;
+};
+
+/*
+ * Collects events of a single type for a BatchListener and delivers them in windows.
+ *
+ * A window closes once it holds maxEvents events, or once maxDelay passed since its first event. Events are
+ * copied into a buffer that is reused for every window, so steady state delivery does not allocate.
+ *
+ * @tparam EType The event type collected.
+ */
+template <EventType EType>
+class EventBatch : public IEventBatch
+{
+public:
+	/*
+	 * @param listener The listener receiving the batches, held as a weak pointer.
+	 * @param maxEvents Number of events after which a window closes, at least 1.
+	 * @param maxDelay Time after the first event of a window after which it closes, zero to close windows by size only.
+	 */
+	EventBatch(const std::shared_ptr<BatchListener<EType>>& listener, std::size_t maxEvents,
+		std::chrono::nanoseconds maxDelay)
+		: receiver(listener),
+		id(listener.get()),
+		maxEvents(maxEvents != 0 ? maxEvents : 1),
+		maxDelay(maxDelay)
+	{
+		collected.reserve(this->maxEvents);
+		delivered.reserve(this->maxEvents);
+	}
+
+	/*
+	 * Add an event to the current window, delivering the window if it is over.
+	 *
+	 * @return False if the listener expired.
+	 */
+	bool append(const EType& event)
+	{
+		if (expired())
+			return false;
+
+		if (collected.empty() && maxDelay.count() > 0)
+			windowStart = std::chrono::steady_clock::now();
+		collected.push_back(event);
+		return flush(false);
+	}
+
+	bool flush(bool force) override
+	{
+		if (collected.empty() || delivering || !(force || windowOver()))
+			return !expired();
+
+		auto listener = receiver.lock();
+		if (!listener)
+			return false;
+
+		// Deliver from the second buffer, so the listener may cause events to be appended meanwhile.
+		std::swap(collected, delivered);
+		delivering = true;
+		listener->onBatch(delivered);
+		delivering = false;
+		delivered.clear();
+		return true;
+	}
+
+	bool expired() const noexcept override
+	{
+		return receiver.expired();
+	}
+
+	EventTypeKey type() const noexcept override
+	{
+		return eventTypeKey<EType>();
+	}
+
+	const IEventListener* listener() const noexcept override
+	{
+		return id;
+	}
+
+	std::size_t memoryUsage() const noexcept override
+	{
+		return (collected.capacity() + delivered.capacity()) * sizeof(EType);
+	}
+
+	/// Number of events in the current window.
+	std::size_t size() const noexcept
+	{
+		return collected.size();
+	}
+
+private:
+	bool windowOver() const
+	{
+		if (collected.size() >= maxEvents)
+			return true;
+		return maxDelay.count() > 0 && std::chrono::steady_clock::now() - windowStart >= maxDelay;
+	}
+
+	std::weak_ptr<BatchListener<EType>> receiver;
+	const IEventListener* id;
+	std::size_t maxEvents;
+	std::chrono::nanoseconds maxDelay;
+	std::chrono::steady_clock::time_point windowStart;
+	std::vector<EType> collected;
+	std::vector<EType> delivered;
+	bool delivering = false;
+};
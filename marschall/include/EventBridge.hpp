@@ -0,0 +1,408 @@
+#pragma once
+#include "EventDispatcher.hpp"
+#include "EventSerialization.hpp"
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <span>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/// Header preceding each batch of events sent over a bridge.
+struct EventBridgeFrame
+{
+	/// Bytes of records following the header.
+	std::uint32_t size;
+	/// Number of records following the header.
+	std::uint32_t count;
+};
+
+/// Header preceding each event within a frame.
+struct EventBridgeRecord
+{
+	std::uint32_t size;
+	std::uint32_t reserved;
+	EventTypeId type;
+};
+
+/*
+ * Forwards events of selected types from a dispatcher to another process over a stream socket.
+ *
+ * Events are serialized into a batch which is sent as one framed message once it reaches a size limit or once
+ * its oldest event has waited for the latency budget, whichever comes first.
+ *
+ * @remarks The sender takes ownership of the socket, typically a connected Unix domain socket.
+ *          It must be used from the thread dispatching the forwarded events.
+ */
+class EventBridgeSender
+{
+public:
+
+	/*
+	 * @param socket A connected stream socket, closed by the sender.
+	 * @param maxBatchBytes Bytes of events after which a batch is sent.
+	 * @param latencyBudget Time after which a batch is sent regardless of its size.
+	 */
+	explicit EventBridgeSender(int socket, std::size_t maxBatchBytes = std::size_t{ 64 } << 10,
+		std::chrono::microseconds latencyBudget = std::chrono::milliseconds(1))
+		: socket(socket), maxBatchBytes(maxBatchBytes), latencyBudget(latencyBudget)
+	{
+	}
+
+	EventBridgeSender(const EventBridgeSender&) = delete;
+	EventBridgeSender& operator=(const EventBridgeSender&) = delete;
+
+	~EventBridgeSender()
+	{
+		flush();
+		if (socket != -1)
+			::close(socket);
+	}
+
+	/*
+	 * Forward all events of the given types dispatched through a dispatcher.
+	 *
+	 * @tparam EType The event types to forward.
+	 * @param dispatcher The dispatcher to subscribe to.
+	 *
+	 * @remarks The subscriptions end when the sender is destroyed.
+	 */
+	template <SerializableEvent... EType>
+	void forward(EventDispatcher& dispatcher)
+	{
+		(forwardOne<EType>(dispatcher), ...);
+	}
+
+	/*
+	 * Add an event to the current batch, sending the batch if it is due.
+	 *
+	 * @tparam EType The event type.
+	 * @param event The event to send.
+	 * @return False if the socket failed, the event is lost in that case.
+	 */
+	template <SerializableEvent EType>
+	bool send(const EType& event)
+	{
+		if (socket == -1)
+			return false;
+
+		if (count == 0)
+			batchStart = std::chrono::steady_clock::now();
+
+		std::size_t start = batch.size();
+		batch.resize(start + sizeof(EventBridgeRecord));
+		EventCodec<EType>::encode(event, batch);
+
+		EventBridgeRecord record{ static_cast<std::uint32_t>(batch.size() - start - sizeof(EventBridgeRecord)), 0, eventTypeId<EType>() };
+		std::memcpy(batch.data() + start, &record, sizeof(record));
+		++count;
+
+		if (batch.size() >= maxBatchBytes || std::chrono::steady_clock::now() - batchStart >= latencyBudget)
+			return flush();
+		return true;
+	}
+
+	/// Send the current batch if its latency budget has run out. Call regularly while events are sparse.
+	bool poll()
+	{
+		if (count != 0 && std::chrono::steady_clock::now() - batchStart >= latencyBudget)
+			return flush();
+		return socket != -1;
+	}
+
+	/// Send the current batch immediately.
+	bool flush()
+	{
+		if (socket == -1)
+			return false;
+		if (count == 0)
+			return true;
+
+		EventBridgeFrame frame{ static_cast<std::uint32_t>(batch.size()), static_cast<std::uint32_t>(count) };
+		iovec parts[2] = {
+			{ &frame, sizeof(frame) },
+			{ batch.data(), batch.size() }
+		};
+
+		bool sent = sendAll(parts);
+		batch.clear();
+		count = 0;
+		if (!sent)
+		{
+			::close(socket);
+			socket = -1;
+			return false;
+		}
+		++frames;
+		return true;
+	}
+
+	bool isOpen() const noexcept
+	{
+		return socket != -1;
+	}
+
+	/// Number of frames sent so far.
+	std::size_t framesSent() const noexcept
+	{
+		return frames;
+	}
+
+private:
+	template <SerializableEvent EType>
+	class Forwarder : public EventListener<EType>
+	{
+	public:
+		explicit Forwarder(EventBridgeSender& sender) : sender(sender) {}
+
+		void onEvent(const EType& event) override
+		{
+			sender.send(event);
+		}
+
+	private:
+		EventBridgeSender& sender;
+	};
+
+	template <SerializableEvent EType>
+	void forwardOne(EventDispatcher& dispatcher)
+	{
+		auto forwarder = std::make_shared<Forwarder<EType>>(*this);
+		dispatcher.subscribeTo<EType>(forwarder);
+		forwarders.push_back(std::move(forwarder));
+	}
+
+	bool sendAll(std::span<iovec> parts) noexcept
+	{
+		while (!parts.empty())
+		{
+			msghdr message{};
+			message.msg_iov = parts.data();
+			message.msg_iovlen = parts.size();
+#if defined(MSG_NOSIGNAL)
+			ssize_t sent = ::sendmsg(socket, &message, MSG_NOSIGNAL);
+#else
+			ssize_t sent = ::sendmsg(socket, &message, 0);
+#endif
+			if (sent < 0 && errno == EINTR)
+				continue;
+			if (sent <= 0)
+				return false;
+
+			std::size_t remaining = static_cast<std::size_t>(sent);
+			while (!parts.empty() && remaining >= parts.front().iov_len)
+			{
+				remaining -= parts.front().iov_len;
+				parts = parts.subspan(1);
+			}
+			if (!parts.empty())
+			{
+				parts.front().iov_base = static_cast<std::byte*>(parts.front().iov_base) + remaining;
+				parts.front().iov_len -= remaining;
+			}
+		}
+		return true;
+	}
+
+	int socket;
+	std::size_t maxBatchBytes;
+	std::chrono::microseconds latencyBudget;
+	std::chrono::steady_clock::time_point batchStart;
+	std::vector<std::byte> batch;
+	std::size_t count = 0;
+	std::size_t frames = 0;
+	std::vector<std::shared_ptr<IEventListener>> forwarders;
+};
+
+/*
+ * Receives events sent by an EventBridgeSender and dispatches them into a local dispatcher.
+ *
+ * @remarks The receiver takes ownership of the socket. Events of types that were not accepted are skipped.
+ */
+class EventBridgeReceiver
+{
+public:
+	/// Bytes requested from the socket at once.
+	static constexpr std::size_t readSize = std::size_t{ 64 } << 10;
+
+	/*
+	 * @param socket A connected stream socket, closed by the receiver.
+	 * @param maxFrameBytes Bytes of records a frame may hold. A larger frame closes the connection.
+	 * @param maxReceiveBytes Bytes read from the socket per receive call, the rest waits for the next call.
+	 */
+	explicit EventBridgeReceiver(int socket, std::size_t maxFrameBytes = std::size_t{ 16 } << 20,
+		std::size_t maxReceiveBytes = std::size_t{ 1 } << 20)
+		: socket(socket), maxFrameBytes(maxFrameBytes), maxReceiveBytes(maxReceiveBytes != 0 ? maxReceiveBytes : readSize)
+	{
+	}
+
+	EventBridgeReceiver(const EventBridgeReceiver&) = delete;
+	EventBridgeReceiver& operator=(const EventBridgeReceiver&) = delete;
+
+	~EventBridgeReceiver()
+	{
+		if (socket != -1)
+			::close(socket);
+	}
+
+	/*
+	 * Accept events of the given types.
+	 *
+	 * @tparam EType The event types to dispatch when received.
+	 */
+	template <SerializableEvent... EType>
+	void accept()
+	{
+		(decoders.try_emplace(eventTypeId<EType>(), &replay<EType>), ...);
+	}
+
+	/*
+	 * Wait for events and dispatch all completely received frames.
+	 *
+	 * @param dispatcher The dispatcher to dispatch the events with.
+	 * @param timeoutMilliseconds Time to wait for data, 0 to return immediately and -1 to wait indefinitely.
+	 * @return The number of events dispatched.
+	 */
+	std::size_t receive(EventDispatcher& dispatcher, int timeoutMilliseconds = 0)
+	{
+		if (socket == -1)
+			return 0;
+
+		pollfd descriptor{ socket, POLLIN, 0 };
+		int ready = ::poll(&descriptor, 1, timeoutMilliseconds);
+		if (ready <= 0)
+			return 0;
+
+		for (std::size_t read = 0; read < maxReceiveBytes;)
+		{
+			std::size_t request = std::min(readSize, maxReceiveBytes - read);
+			reserve(request);
+			ssize_t received = ::recv(socket, buffer.data() + tail, request, MSG_DONTWAIT);
+
+			if (received > 0)
+			{
+				tail += static_cast<std::size_t>(received);
+				read += static_cast<std::size_t>(received);
+				continue;
+			}
+			if (received < 0 && errno == EINTR)
+				continue;
+			if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+				disconnect();
+			break;
+		}
+
+		return dispatchFrames(dispatcher);
+	}
+
+	/// False once the sender closed the connection or the socket failed.
+	bool isOpen() const noexcept
+	{
+		return socket != -1;
+	}
+
+	/// Number of received events that were skipped because their type was not accepted or they failed to decode.
+	std::size_t skipped() const noexcept
+	{
+		return unknown;
+	}
+
+private:
+	using Decoder = bool (*)(std::span<const std::byte>, EventDispatcher&);
+
+	template <SerializableEvent EType>
+	static bool replay(std::span<const std::byte> payload, EventDispatcher& dispatcher)
+	{
+		std::optional<EType> event = EventCodec<EType>::decode(payload);
+		if (!event)
+			return false;
+
+		dispatcher.dispatch(std::move(*event));
+		return true;
+	}
+
+	/*
+	 * Make room for the given number of bytes after the received data.
+	 *
+	 * The buffer is only compacted and grown when it runs out of room, so its capacity is reused across calls.
+	 */
+	void reserve(std::size_t bytes)
+	{
+		if (buffer.size() - tail >= bytes)
+			return;
+
+		if (head != 0)
+		{
+			std::memmove(buffer.data(), buffer.data() + head, tail - head);
+			tail -= head;
+			head = 0;
+		}
+		if (buffer.size() - tail < bytes)
+			buffer.resize(tail + bytes);
+	}
+
+	void disconnect() noexcept
+	{
+		::close(socket);
+		socket = -1;
+	}
+
+	std::size_t dispatchFrames(EventDispatcher& dispatcher)
+	{
+		std::size_t dispatched = 0;
+		while (tail - head >= sizeof(EventBridgeFrame))
+		{
+			EventBridgeFrame frame;
+			std::memcpy(&frame, buffer.data() + head, sizeof(frame));
+			if (frame.size > maxFrameBytes)
+			{
+				// The stream can't be resynchronized, so drop it rather than buffer a frame of any size.
+				if (socket != -1)
+					disconnect();
+				head = tail;
+				break;
+			}
+			if (tail - head - sizeof(frame) < frame.size)
+				break;
+
+			std::span<const std::byte> records(buffer.data() + head + sizeof(frame), frame.size);
+			while (records.size() >= sizeof(EventBridgeRecord))
+			{
+				EventBridgeRecord record;
+				std::memcpy(&record, records.data(), sizeof(record));
+				if (records.size() - sizeof(record) < record.size)
+					break;
+
+				auto it = decoders.find(record.type);
+				if (it != decoders.end() && it->second(records.subspan(sizeof(record), record.size), dispatcher))
+					++dispatched;
+				else
+					++unknown;
+				records = records.subspan(sizeof(record) + record.size);
+			}
+			head += sizeof(frame) + frame.size;
+		}
+
+		if (head == tail)
+			head = tail = 0;
+		return dispatched;
+	}
+
+	int socket;
+	std::size_t maxFrameBytes;
+	std::size_t maxReceiveBytes;
+	std::unordered_map<EventTypeId, Decoder> decoders;
+	/// Received bytes are those from head to tail, the buffer's size is the capacity reused for reading.
+	std::vector<std::byte> buffer;
+	std::size_t head = 0;
+	std::size_t tail = 0;
+	std::size_t unknown = 0;
+};
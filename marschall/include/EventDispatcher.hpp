@@ -1,48 +1,163 @@
 #pragma once
 #include "EventListener.hpp"
+#include "EventStream.hpp"
+#include "ThreadPool.hpp"
+#include "QueryReducers.hpp"
+#include "EventQueue.hpp"
+#include "StaticSubscriptions.hpp"
+#include "EventSerialization.hpp"
+#include "EventSpill.hpp"
+#include "EventBatch.hpp"
+#include "SignalEventQueue.hpp"
+#include "Trace.hpp"
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <functional>
 #include <algorithm>
-#include <queue>
+#include <vector>
+#include <atomic>
+#include <latch>
+#include <initializer_list>
+#include <concepts>
+#include <span>
+#include <cstring>
+#include <optional>
+#include <chrono>
+#include <array>
+#include <cassert>
+#if defined(__cpp_rtti)
+#include <typeinfo>
+#include <typeindex>
+#endif
+
+/*
+ * Limits for the time a listener may take to handle an event, see EventDispatcher::setListenerWatchdog.
+ */
+struct ListenerWatchdog
+{
+	/// Time a single notification may take, zero disables the watchdog.
+	std::chrono::nanoseconds budget{ 0 };
+	/// Every how many dispatches of a type its listeners are timed, 1 times every dispatch.
+	std::uint32_t sampleInterval = 64;
+	/// Number of sampled violations after which a listener is quarantined, zero never quarantines.
+	std::uint32_t quarantineAfter = 0;
+};
+
+/// A listener that exceeded the watchdog's budget.
+struct SlowListener
+{
+	EventTypeKey type;
+	const IEventListener* listener;
+	/// Number of sampled notifications that exceeded the budget.
+	std::uint32_t violations;
+	/// The longest sampled notification.
+	std::chrono::nanoseconds worst;
+	/// Whether the listener is no longer notified.
+	bool quarantined;
+};
+
+/// Priority of a queued event, processQueue delivers events of higher priorities first.
+enum class EventPriority : std::uint8_t
+{
+	Low,
+	Normal,
+	High,
+	Urgent
+};
+
+inline constexpr std::size_t eventPriorityLevels = 4;
+
+/// Memory held by an EventDispatcher, see EventDispatcher::memoryUsage.
+struct DispatcherMemoryUsage
+{
+	/// Memory held for a single event type.
+	struct Type
+	{
+		EventTypeKey type;
+		/// Subscriber set, dependency order and callback state of listeners.
+		std::size_t subscribers;
+		/// Responders to queries and the consumer.
+		std::size_t responders;
+		/// Events buffered for readers.
+		std::size_t stream;
+	};
+
+	std::vector<Type> types;
+	/// Buckets and nodes of the per-type table.
+	std::size_t table = 0;
+	/// Storage of queued events, including chunks kept for reuse.
+	std::size_t queue = 0;
+	/// Sum of all of the above.
+	std::size_t total = 0;
+};
 
 /*
  * EventDispatcher manages event subscriptions and dispatching.
  * 
  * Listeners can subscribe to specific event types, and events can be dispatched to notify those listeners.
  * Supports one-time subscriptions and automatic removal of expired listeners.
+ * Events can additionally be pulled in bulk through per-type event streams.
+ *
+ * Listeners of a type are notified in an order honoring their declared dependencies. With a thread pool
+ * attached, independent listeners are notified concurrently.
+ * Query listeners answer requests, their results are combined by a reducer.
+ * A single consumer per type may take ownership of events after all listeners have seen them.
+ * Batch listeners receive events collected over a window of time or count as a single span.
+ * Subscriptions known at compile time can be attached as a static table, notified before all others.
+ * Queued events are delivered by priority, each priority in the order it was queued.
+ * Queued events beyond a memory budget can overflow into a spill, such as files on disk.
+ * A watchdog can time listeners and quarantine those repeatedly blocking dispatch.
  */
 class EventDispatcher
 {
 public:
+	EventDispatcher() = default;
+
+	/*
+	 * Create a dispatcher with an initial set of static subscriptions.
+	 *
+	 * @param topology The topology of a StaticSubscriptionTable, such as Table::topology.
+	 *
+	 * @remarks Static subscriptions are resolved at compile time, attaching them neither hashes nor allocates.
+	 *          They cannot be unsubscribed and are notified before dynamically subscribed listeners.
+	 */
+	explicit EventDispatcher(const StaticTopology& topology)
+		: staticTopology(&topology)
+	{
+	}
 
 	/*
 	 * Subscribe a listener to a specific event type.
 	 *
 	 * @tparam EType The event type to subscribe to.
 	 * @param listener A shared pointer to the listener.
+	 * @param runsAfter Listeners of the same event type that must be notified before this one.
 	 *
 	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
+	 *          Dependencies on listeners that are not subscribed are ignored, as are dependencies closing a cycle.
 	 */
 	template <EventType EType>
-	void subscribeTo(const std::shared_ptr<EventListener<EType>>& listener)
+	void subscribeTo(const std::shared_ptr<EventListener<EType>>& listener,
+		std::initializer_list<const EventListener<EType>*> runsAfter = {})
 	{
-		auto& subs = subscriptions[typeid(EType).hash_code()];
-
 		std::weak_ptr<EventListener<EType>> weak = listener;
 
 		const IEventListener* id = listener.get();
 
-		subs.emplace(Subscriber{
+		subscribe(channelKey<EType>(), Subscriber{
 			id,
-			[weak = std::move(weak)](const Event& event)
+			[weak = std::move(weak)](const void* event)
 			{
+				if (!event)
+					return !weak.expired();
 				if (auto l = weak.lock())
-					l->onEvent(static_cast<const EType&>(event));
+					l->onEvent(*static_cast<const EType*>(event));
 				else
 					return false;
 				return true;
-			}
+			},
+			std::vector<const IEventListener*>(runsAfter.begin(), runsAfter.end())
 			});
 	}
 
@@ -66,27 +181,30 @@ public:
 	 *
 	 * @tparam EType The event type to subscribe to.
 	 * @param listener A shared pointer to the listener.
+	 * @param runsAfter Listeners of the same event type that must be notified before this one.
 	 *
 	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
 	 *          After the first event is received, the listener is automatically unsubscribed.
 	 */
 	template <EventType EType>
-	void subscribeOnceTo(const std::shared_ptr<EventListener<EType>>& listener)
+	void subscribeOnceTo(const std::shared_ptr<EventListener<EType>>& listener,
+		std::initializer_list<const EventListener<EType>*> runsAfter = {})
 	{
-		auto& subs = subscriptions[typeid(EType).hash_code()];
-
 		std::weak_ptr<EventListener<EType>> weak = listener;
 
 		const IEventListener* id = listener.get();
 
-		subs.emplace(Subscriber{
+		subscribe(channelKey<EType>(), Subscriber{
 			id,
-			[weak = std::move(weak)](const Event& event)
+			[weak = std::move(weak)](const void* event)
 			{
+				if (!event)
+					return !weak.expired();
 				if (auto l = weak.lock())
-					l->onEvent(static_cast<const EType&>(event));
+					l->onEvent(*static_cast<const EType*>(event));
 				return false;
-			}
+			},
+			std::vector<const IEventListener*>(runsAfter.begin(), runsAfter.end())
 			});
 	}
 
@@ -136,6 +254,128 @@ public:
 		(unsubscribeFrom<EType>(listener.get()), ...);
 	}
 
+	/*
+	 * Subscribe a listener to receive events of a specific type in batches.
+	 *
+	 * Events are copied into a buffer reused across windows. A window is delivered once it holds maxEvents
+	 * events, once maxDelay passed since its first event, or when the batches are flushed.
+	 *
+	 * @tparam EType The event type to subscribe to.
+	 * @param listener A shared pointer to the listener.
+	 * @param maxEvents Number of events per batch.
+	 * @param maxDelay Longest time an event waits for its batch to be delivered, zero to batch by count only.
+	 *
+	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
+	 *          Windows closing by time are checked whenever an event is added, by processQueue and by pollBatches.
+	 */
+	template <EventType EType>
+		requires std::is_copy_constructible_v<EType>
+	void subscribeBatchTo(const std::shared_ptr<BatchListener<EType>>& listener, std::size_t maxEvents,
+		std::chrono::nanoseconds maxDelay = std::chrono::nanoseconds(0))
+	{
+		const IEventListener* id = listener.get();
+		auto it = channels.find(eventTypeKey<EType>());
+		if (it != channels.end() && it->second.subscribers.contains(id))
+			return;
+
+		auto batch = std::make_shared<EventBatch<EType>>(listener, maxEvents, maxDelay);
+		batches.push_back(batch);
+
+		subscribe(channelKey<EType>(), Subscriber{
+			id,
+			[batch = std::move(batch)](const void* event)
+			{
+				if (!event)
+					return !batch->expired();
+				return batch->append(*static_cast<const EType*>(event));
+			},
+			{}
+			});
+	}
+
+	/*
+	 * Unsubscribe a batch listener from a specific event type, delivering the events it has collected.
+	 *
+	 * @tparam EType The event type to unsubscribe from.
+	 * @param listener A shared pointer to the listener.
+	 */
+	template <EventType EType>
+	void unsubscribeBatchFrom(const std::shared_ptr<BatchListener<EType>>& listener)
+	{
+		const IEventListener* id = listener.get();
+		unsubscribe(eventTypeKey<EType>(), id);
+
+		auto it = std::ranges::find_if(batches, [id](const std::shared_ptr<IEventBatch>& batch) {
+			return batch->listener() == id && batch->type() == eventTypeKey<EType>();
+			});
+		if (it != batches.end())
+		{
+			std::shared_ptr<IEventBatch> batch = std::move(*it);
+			batches.erase(it);
+			batch->flush(true);
+		}
+	}
+
+	/// Deliver the batches whose window closed because their delay passed.
+	void pollBatches()
+	{
+		closeBatches(false);
+	}
+
+	/// Deliver all collected events to their batch listeners, regardless of their windows.
+	void flushBatches()
+	{
+		closeBatches(true);
+	}
+
+	/*
+	 * Subscribe the consumer taking ownership of events of a specific type.
+	 *
+	 * The consumer is notified after all listeners of the event. Events dispatched as rvalues or from the
+	 * queue are moved into the consumer, other events are copied if the event type is copyable.
+	 *
+	 * @tparam EType The event type to consume.
+	 * @param consumer A shared pointer to the consumer.
+	 *
+	 * @remarks The consumer is stored as a weak pointer to avoid dangling references.
+	 *          Each event type has at most one consumer, subscribing replaces the previous one.
+	 */
+	template <EventType EType>
+	void subscribeConsumerTo(const std::shared_ptr<EventConsumer<EType>>& consumer)
+	{
+		std::weak_ptr<EventConsumer<EType>> weak = consumer;
+
+		channels[channelKey<EType>()].consumer = Consumer{
+			consumer.get(),
+			[weak = std::move(weak)](const void* event, bool owned)
+			{
+				auto c = weak.lock();
+				if (!c)
+					return false;
+
+				if (owned)
+					c->onEvent(std::move(*static_cast<EType*>(const_cast<void*>(event))));
+				else if constexpr (std::is_copy_constructible_v<EType>)
+					c->onEvent(EType(*static_cast<const EType*>(event)));
+				return true;
+			}
+		};
+	}
+
+	/*
+	 * Unsubscribe the consumer of a specific event type.
+	 *
+	 * @tparam EType The event type to stop consuming.
+	 * @param consumer A shared pointer to the consumer.
+	 */
+	template <EventType EType>
+	void unsubscribeConsumerFrom(const std::shared_ptr<EventConsumer<EType>>& consumer)
+	{
+		auto it = channels.find(eventTypeKey<EType>());
+		if (it != channels.end() && it->second.consumer.id == consumer.get())
+			it->second.consumer = {};
+	}
+
 	/*
 	 * Dispatch an event to all subscribed listeners.
 	 *
@@ -146,13 +386,8 @@ public:
 	 */
 	void dispatch(const Event& event)
 	{
-		auto it = subscriptions.find(typeid(event).hash_code());
-		if (it != subscriptions.end())
-		{
-			std::erase_if(it->second, [&event](const Subscriber& s) {
-				return !s.callback(event);
-				});
-		}
+		auto [key, object] = identify(event);
+		deliver(key, object);
 	}
 	/*
 	 * Dispatch a specific event type to all subscribed listeners.
@@ -166,83 +401,1421 @@ public:
 	 * 
 	 */
 	template <EventType EType>
-		requires !std::is_same_v<EType, Event>
+		requires (!std::is_same_v<EType, Event>)
 	void dispatch(const EType& event)
 	{
-		auto it = subscriptions.find(typeid(event).hash_code());
-		if (it != subscriptions.end())
-		{
-			std::erase_if(it->second, [&event](const Subscriber& s) {
-				return !s.callback(event);
-				});
-		}
+		auto [key, object] = identify(event);
+		deliver(key, object);
 	}
 
 	/*
-	 * Queue an event for later processing.
+	 * Dispatch an event to all subscribed listeners, then move it into the consumer of its type.
 	 *
-	 * The event will be processed when processQueue is called.
+	 * This blocks until all listeners have been notified.
 	 *
-	 * @param event A unique pointer to the event to queue.
+	 * @tparam EType The event type to dispatch.
+	 * @param event The event to dispatch, left in a moved-from state if a consumer took it.
 	 */
-	void queueEvent(std::unique_ptr<Event> event)
+	template <EventType EType>
+		requires (!std::is_reference_v<EType> && !std::is_same_v<EType, Event>)
+	void dispatch(EType&& event)
 	{
-		eventQueue.push(std::move(event));
+		auto [key, object] = identify(event);
+		deliver(key, object, true);
 	}
 
 	/*
-	 * Process all queued events, dispatching them to their subscribed listeners.
+	 * Construct an event in place and dispatch it, but only if anyone observes its type.
 	 *
-	 * This blocks until all queued events have been processed.
+	 * Use this for expensive events to skip building them while nobody is subscribed.
+	 *
+	 * @tparam EType The event type to dispatch.
+	 * @param args The arguments to construct the event from.
+	 * @return True if the event was constructed and dispatched.
 	 */
-	void processQueue()
+	template <EventType EType, typename... Args>
+	bool dispatchEmplace(Args&&... args)
+	{
+		Channel* channel = nullptr;
+		if (!observed(eventTypeKey<EType>(), channel))
+			return false;
+
+		EType event(std::forward<Args>(args)...);
+		deliver(channel, eventTypeKey<EType>(), &event, true);
+		return true;
+	}
+
+	/*
+	 * Build an event through a factory and dispatch it, but only if anyone observes its type.
+	 *
+	 * @tparam EType The event type to dispatch.
+	 * @param factory Callable returning the event, only invoked if the event is dispatched.
+	 * @return True if the event was built and dispatched.
+	 */
+	template <EventType EType, std::invocable Factory>
+	bool dispatchLazy(Factory&& factory)
+	{
+		Channel* channel = nullptr;
+		if (!observed(eventTypeKey<EType>(), channel))
+			return false;
+
+		EType event = std::forward<Factory>(factory)();
+		deliver(channel, eventTypeKey<EType>(), &event, true);
+		return true;
+	}
+
+	/*
+	 * Check whether any listener or reader currently observes an event type.
+	 *
+	 * @tparam EType The event type.
+	 * @return True if dispatching an event of this type would reach anyone.
+	 *
+	 * @remarks Listeners that expired since the last dispatch are still counted.
+	 */
+	template <EventType EType>
+	bool hasSubscribers()
+	{
+		Channel* channel = nullptr;
+		return observed(eventTypeKey<EType>(), channel);
+	}
+
+	/*
+	 * Subscribe a listener to answer requests of a specific query type.
+	 *
+	 * @tparam QType The query type to answer.
+	 * @param listener A shared pointer to the listener.
+	 *
+	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
+	 *          Listeners are asked in the order they subscribed.
+	 */
+	template <QueryType QType>
+	void subscribeResponder(const std::shared_ptr<QueryListener<QType>>& listener)
+	{
+		auto& responders = channels[eventTypeKey<QType>()].responders;
+
+		const IEventListener* id = listener.get();
+		if (std::ranges::any_of(responders, [id](const Responder& r) { return r.id == id; }))
+			return;
+
+		std::weak_ptr<QueryListener<QType>> weak = listener;
+
+		responders.push_back(Responder{
+			id,
+			[weak = std::move(weak)](const void* query, void* sink)
+			{
+				auto l = weak.lock();
+				if (!l)
+					return Response::Expired;
+
+				auto& results = *static_cast<ResultSink<typename QType::Result>*>(sink);
+				return results.accept(l->onQuery(*static_cast<const QType*>(query)))
+					? Response::Continue
+					: Response::Satisfied;
+			}
+			});
+	}
+
+	/*
+	 * Unsubscribe a listener from answering requests of a specific query type.
+	 *
+	 * @tparam QType The query type to stop answering.
+	 * @param listener A shared pointer to the listener.
+	 */
+	template <QueryType QType>
+	void unsubscribeResponder(const std::shared_ptr<QueryListener<QType>>& listener)
+	{
+		auto it = channels.find(eventTypeKey<QType>());
+		if (it == channels.end())
+			return;
+
+		const IEventListener* id = listener.get();
+		std::erase_if(it->second.responders, [id](const Responder& r) { return r.id == id; });
+	}
+
+	/*
+	 * Ask all responders of a query type and combine their answers.
+	 *
+	 * Each responder's result is handed to the reducer. Once the reducer is satisfied, the remaining
+	 * responders are skipped. Results are passed straight to the reducer without allocating.
+	 *
+	 * @tparam QType The query type.
+	 * @param query The query to answer.
+	 * @param reducer The reducer combining the results, such as FirstResult, AnyResult or CollectResults.
+	 * @return The reducer's result.
+	 */
+	template <QueryType QType, ResultReducer<typename QType::Result> Reducer>
+	auto request(const QType& query, Reducer reducer)
 	{
-		while (!eventQueue.empty())
+		auto it = channels.find(eventTypeKey<QType>());
+		if (it != channels.end())
 		{
-			dispatch(*eventQueue.front());
-			eventQueue.pop();
+			ReducerSink<typename QType::Result, Reducer> sink(reducer);
+
+			auto& responders = it->second.responders;
+			bool expired = false;
+			for (Responder& responder : responders)
+			{
+				Response response = responder.respond(&query, &sink);
+				if (response == Response::Expired)
+				{
+					responder.id = nullptr;
+					expired = true;
+				}
+				else if (response == Response::Satisfied)
+				{
+					break;
+				}
+			}
+
+			if (expired)
+				std::erase_if(responders, [](const Responder& r) { return r.id == nullptr; });
 		}
+		return reducer.result();
 	}
 
-private:
+	/*
+	 * Create a reader pulling events of a specific type from the dispatcher.
+	 *
+	 * Every event of this type dispatched after the reader was created is appended by value to a
+	 * contiguous per-type stream, from which each reader consumes at its own pace.
+	 *
+	 * @tparam EType The event type to read.
+	 * @return A reader with its own cursor into the event stream.
+	 *
+	 * @remarks Streams work alongside subscriptions, listeners are still notified as usual.
+	 */
 	template <EventType EType>
-	void unsubscribeFrom(const EventListener<EType>* id)
+	EventReader<EType> createReader()
 	{
-		auto& subs = subscriptions[typeid(EType).hash_code()];
+		auto& stream = channels[channelKey<EType>()].stream;
+		if (!stream)
+			stream = std::make_shared<EventStream<EType>>();
 
-		subs.erase(static_cast<const IEventListener*>(id));
+		return static_cast<EventStream<EType>&>(*stream).createReader();
 	}
 
-	using Callback = std::function<bool(const Event&)>;
+	/*
+	 * Notify independent listeners concurrently on a thread pool.
+	 *
+	 * Dispatch still blocks until all listeners have been notified, and a listener is only notified once
+	 * all listeners it runs after are done. The dispatching thread helps executing listeners while waiting.
+	 *
+	 * @param pool The thread pool to use, or nullptr to notify listeners sequentially.
+	 *
+	 * @remarks The dispatcher itself is not synchronized. Listeners notified in parallel must not call into it,
+	 *          neither dispatch, queueEvent, cancel nor subscribe or unsubscribe, not even for other types.
+	 *          Collect their follow-up events elsewhere, for example in an EventTransaction per listener, and
+	 *          queue them after dispatch returned.
+	 */
+	void setThreadPool(std::shared_ptr<ThreadPool> pool)
+	{
+		threadPool = std::move(pool);
+	}
 
-	struct Subscriber
+	/*
+	 * Time listeners and report or quarantine those exceeding a budget.
+	 *
+	 * Only every sampleInterval-th dispatch of a type is timed, other dispatches cost a single counter decrement.
+	 * Quarantined listeners stay subscribed but are skipped until restored.
+	 *
+	 * @param watchdog The limits, a zero budget disables timing. Recorded violations are kept.
+	 */
+	void setListenerWatchdog(ListenerWatchdog watchdog)
 	{
-		const IEventListener* id;
-		Callback callback;
-	};
+		if (watchdog.sampleInterval == 0)
+			watchdog.sampleInterval = 1;
+		listenerWatchdog = watchdog;
+	}
 
-	struct SubscriberHash {
-		using is_transparent = void;
-		std::size_t operator()(const Subscriber& s) const noexcept {
-			return std::hash<const IEventListener*>{}(s.id);
+	/*
+	 * List the listeners that exceeded the watchdog's budget in a sampled notification.
+	 *
+	 * @return The slow listeners of all event types, including quarantined ones.
+	 */
+	std::vector<SlowListener> slowListeners() const
+	{
+		std::vector<SlowListener> report;
+		for (const auto& [key, channel] : channels)
+			for (const Subscriber& subscriber : channel.subscribers)
+				if (subscriber.violations != 0)
+					report.push_back({ key, subscriber.id, subscriber.violations, subscriber.worst, subscriber.quarantined });
+		return report;
+	}
+
+	/*
+	 * Notify a quarantined listener again and forget its violations.
+	 *
+	 * @tparam EType The event type the listener was quarantined for.
+	 * @param listener A shared pointer to the listener.
+	 */
+	template <EventType EType>
+	void restoreListener(const std::shared_ptr<EventListener<EType>>& listener)
+	{
+		auto it = channels.find(eventTypeKey<EType>());
+		if (it == channels.end())
+			return;
+
+		auto sub = it->second.subscribers.find(static_cast<const IEventListener*>(listener.get()));
+		if (sub != it->second.subscribers.end())
+		{
+			sub->violations = 0;
+			sub->worst = {};
+			sub->quarantined = false;
 		}
-		std::size_t operator()(const IEventListener* id) const noexcept {
-			return std::hash<const IEventListener*>{}(id);
+	}
+
+	/*
+	 * Remove subscribers whose listener expired, visiting event types round-robin.
+	 *
+	 * Expired listeners are otherwise only removed when their type is dispatched, until then the weak reference
+	 * keeps the memory of a listener created by make_shared allocated. Call this periodically, for example
+	 * once per frame, to release it for rarely dispatched types without a latency spike.
+	 *
+	 * @param budget Number of subscribers to check in this call. Each call continues where the previous call
+	 *               stopped, also within the subscribers of a type.
+	 * @return The number of subscribers removed.
+	 *
+	 * @remarks Must not be called from within a listener. See setSweepBudget to sweep from processQueue.
+	 *          Subscribers are checked a hash bucket at a time, each bucket counting at least one against the
+	 *          budget, so a call may exceed it by the collisions of its last bucket.
+	 */
+	std::size_t sweepExpired(std::size_t budget)
+	{
+		if (channels.empty() || budget == 0)
+			return 0;
+
+		auto it = channels.find(sweepCursor);
+		if (it == channels.end())
+		{
+			it = channels.begin();
+			sweepBucket = 0;
 		}
-	};
-	struct SubscriberEqual {
-		using is_transparent = void;
-		bool operator()(const Subscriber& lhs, const Subscriber& rhs) const noexcept {
-			return lhs.id == rhs.id;
+
+		std::size_t checked = 0;
+		std::size_t removed = 0;
+		for (std::size_t visited = 0; visited < channels.size() && checked < budget; ++visited)
+		{
+			Channel& channel = it->second;
+			auto& subscribers = channel.subscribers;
+			if (channel.notifying == 0)
+			{
+				for (; sweepBucket < subscribers.bucket_count() && checked < budget; ++sweepBucket)
+				{
+					checked += std::max<std::size_t>(subscribers.bucket_size(sweepBucket), 1);
+					for (auto s = subscribers.begin(sweepBucket); s != subscribers.end(sweepBucket); ++s)
+						if (!s->callback(nullptr))
+							sweepExpiredIds.push_back(s->id);
+				}
+
+				// Erasing keeps the bucket layout, so the position stays valid for the next call.
+				for (const IEventListener* id : sweepExpiredIds)
+					subscribers.erase(subscribers.find(id));
+				if (!sweepExpiredIds.empty())
+				{
+					channel.dirty = true;
+					removed += sweepExpiredIds.size();
+					sweepExpiredIds.clear();
+				}
+
+				if (sweepBucket < subscribers.bucket_count())
+					break;
+			}
+
+			sweepBucket = 0;
+			if (++it == channels.end())
+				it = channels.begin();
 		}
-		bool operator()(const Subscriber& lhs, const IEventListener* rhs) const noexcept {
-			return lhs.id == rhs;
+		sweepCursor = it->first;
+		return removed;
+	}
+
+	/*
+	 * Sweep expired subscribers at the end of every processQueue call.
+	 *
+	 * @param budget Number of subscribers checked per call, see sweepExpired. Zero disables the sweep.
+	 */
+	void setSweepBudget(std::size_t budget)
+	{
+		sweepBudget = budget;
+	}
+
+	/*
+	 * Estimate the memory held by the dispatcher, broken down per event type.
+	 *
+	 * Node sizes of hash containers and the heap state of callbacks are estimated, memory owned by events,
+	 * listeners and an attached spill is not counted.
+	 *
+	 * @return The memory usage, types are listed in no particular order.
+	 */
+	DispatcherMemoryUsage memoryUsage() const
+	{
+		constexpr std::size_t node = 2 * sizeof(void*);
+		constexpr std::size_t callbackState = sizeof(std::weak_ptr<IEventListener>);
+
+		DispatcherMemoryUsage usage;
+		usage.types.reserve(channels.size());
+		usage.table = channels.bucket_count() * sizeof(void*)
+			+ channels.size() * (node + sizeof(std::pair<const EventTypeKey, Channel>));
+		for (const auto& [key, channel] : channels)
+		{
+			DispatcherMemoryUsage::Type type{ key, 0, 0, 0 };
+
+			type.subscribers = channel.subscribers.bucket_count() * sizeof(void*)
+				+ channel.order.capacity() * sizeof(const Subscriber*)
+				+ channel.successors.capacity() * sizeof(std::vector<std::size_t>)
+				+ channel.predecessors.capacity() * sizeof(std::size_t)
+				+ channel.order.size() * sizeof(std::atomic<std::size_t>);
+			for (const Subscriber& subscriber : channel.subscribers)
+				type.subscribers += node + sizeof(Subscriber) + callbackState
+					+ subscriber.after.capacity() * sizeof(const IEventListener*);
+			for (const std::vector<std::size_t>& successors : channel.successors)
+				type.subscribers += successors.capacity() * sizeof(std::size_t);
+
+			type.responders = channel.responders.capacity() * sizeof(Responder)
+				+ channel.responders.size() * callbackState
+				+ (channel.consumer.consume ? callbackState : 0);
+			type.stream = channel.stream ? channel.stream->memoryUsage() : 0;
+
+			usage.total += type.subscribers + type.responders + type.stream;
+			usage.types.push_back(type);
 		}
-		bool operator()(const IEventListener* lhs, const Subscriber& rhs) const noexcept {
-			return lhs == rhs.id;
+		for (const std::shared_ptr<IEventBatch>& batch : batches)
+		{
+			auto type = std::ranges::find(usage.types, batch->type(), &DispatcherMemoryUsage::Type::type);
+			if (type != usage.types.end())
+				type->subscribers += batch->memoryUsage();
+			usage.total += batch->memoryUsage();
 		}
-	};
+		usage.queue = eventQueue.memoryUsage() + pinned.memoryUsage() + spillRecord.capacity();
+		for (const EventQueue& queue : priorityQueues)
+			usage.queue += queue.memoryUsage();
+		usage.total += usage.table + usage.queue;
+		return usage;
+	}
 
-	std::unordered_map<size_t, std::unordered_set<Subscriber, SubscriberHash, SubscriberEqual>> subscriptions;
-	std::queue<std::unique_ptr<Event>> eventQueue;
-};
+	/*
+	 * Release memory the dispatcher no longer needs.
+	 *
+	 * Removes the entries of event types nobody observes any more, shrinks the containers of the remaining
+	 * types to their size and frees queue storage kept for reuse.
+	 *
+	 * @remarks Must not be called from within a listener.
+	 */
+	void shrink()
+	{
+		std::erase_if(channels, [](const auto& entry) {
+			const Channel& channel = entry.second;
+			return channel.subscribers.empty() && channel.responders.empty() && !channel.consumer.consume
+				&& !(channel.stream && channel.stream->hasReaders());
+			});
+
+		for (auto& [key, channel] : channels)
+		{
+			if (channel.subscribers.empty())
+			{
+				std::vector<const Subscriber*>().swap(channel.order);
+				std::vector<std::vector<std::size_t>>().swap(channel.successors);
+				std::vector<std::size_t>().swap(channel.predecessors);
+				channel.remaining.reset();
+			}
+			else
+			{
+				channel.order.shrink_to_fit();
+				channel.successors.shrink_to_fit();
+				channel.predecessors.shrink_to_fit();
+			}
+			channel.subscribers.rehash(0);
+			channel.responders.shrink_to_fit();
+			if (channel.stream)
+				channel.stream->shrink();
+		}
+		channels.rehash(0);
+
+		eventQueue.trim();
+		pinned.trim();
+		for (EventQueue& queue : priorityQueues)
+			queue.trim();
+		std::vector<std::byte>().swap(spillRecord);
+	}
+
+	/*
+	 * Queue an event for later processing.
+	 *
+	 * The event will be processed when processQueue is called.
+	 *
+	 * @tparam EType The static type of the event.
+	 * @param event A unique pointer to the event to queue.
+	 * @return A ticket to cancel the event with.
+	 *
+	 * @remarks The event is dispatched under its concrete type if it derives from EventBase, or with RTTI if its concrete
+	 *          type is subscribed to, under EType otherwise.
+	 */
+	template <PolymorphicEventType EType>
+	EventQueue::Ticket queueEvent(std::unique_ptr<EType> event)
+	{
+		if (!event)
+			return {};
+
+		auto [key, object] = identify(*event);
+		MARSCHALL_TRACE2(queue, key, queueDepth());
+		if (spilling())
+		{
+			pinned.push(key, std::move(event), const_cast<void*>(object));
+			markPinned();
+			return pinned.back();
+		}
+
+		eventQueue.push(key, std::move(event), const_cast<void*>(object));
+		return eventQueue.back();
+	}
+
+	/*
+	 * Queue an event by value for later processing.
+	 *
+	 * The event is stored inline in the queue, trivially copyable events are copied with memcpy.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 * @return A ticket to cancel the event with.
+	 */
+	template <typename E, EventType EType = std::remove_cvref_t<E>>
+		requires (!std::is_convertible_v<EType, std::unique_ptr<const Event>>)
+	EventQueue::Ticket queueEvent(E&& event)
+	{
+		return enqueue<EType>(std::forward<E>(event));
+	}
+
+	/*
+	 * Construct an event directly in queue storage for later processing.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param args The arguments to construct the event from.
+	 * @return A ticket to cancel the event with.
+	 */
+	template <EventType EType, typename... Args>
+	EventQueue::Ticket queueEmplace(Args&&... args)
+	{
+		return enqueue<EType>(std::forward<Args>(args)...);
+	}
+
+	/*
+	 * Queue an event by value with a priority.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 * @param priority The priority, events of Normal priority are queued as by queueEvent(event).
+	 * @return A ticket to cancel the event with.
+	 *
+	 * @remarks Only events of Normal priority are written to a spill.
+	 */
+	template <typename E, EventType EType = std::remove_cvref_t<E>>
+		requires (!std::is_convertible_v<EType, std::unique_ptr<const Event>>)
+	EventQueue::Ticket queueEvent(E&& event, EventPriority priority)
+	{
+		return queueEmplaceWithPriority<EType>(priority, std::forward<E>(event));
+	}
+
+	/*
+	 * Queue an event with a priority.
+	 *
+	 * @tparam EType The static type of the event.
+	 * @param event A unique pointer to the event to queue.
+	 * @param priority The priority, events of Normal priority are queued as by queueEvent(event).
+	 * @return A ticket to cancel the event with.
+	 */
+	template <PolymorphicEventType EType>
+	EventQueue::Ticket queueEvent(std::unique_ptr<EType> event, EventPriority priority)
+	{
+		if (priority == EventPriority::Normal || !event)
+			return queueEvent(std::move(event));
+
+		auto [key, object] = identify(*event);
+		MARSCHALL_TRACE2(queue, key, queueDepth());
+		EventQueue& queue = priorityQueue(priority);
+		queue.push(key, std::move(event), const_cast<void*>(object));
+		return queue.back();
+	}
+
+	/*
+	 * Construct an event directly in queue storage with a priority.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param priority The priority, events of Normal priority are queued as by queueEmplace.
+	 * @param args The arguments to construct the event from.
+	 * @return A ticket to cancel the event with.
+	 */
+	template <EventType EType, typename... Args>
+	EventQueue::Ticket queueEmplaceWithPriority(EventPriority priority, Args&&... args)
+	{
+		if (priority == EventPriority::Normal)
+			return enqueue<EType>(std::forward<Args>(args)...);
+
+		MARSCHALL_TRACE2(queue, eventTypeKey<EType>(), queueDepth());
+		EventQueue& queue = priorityQueue(priority);
+		queue.emplace<EType>(eventTypeKey<EType>(), std::forward<Args>(args)...);
+		return queue.back();
+	}
+
+	/*
+	 * Queue an event that is dropped instead of delivered if it is still queued at a deadline.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 * @param deadline The point in time after which the event is dropped, see expiredCount.
+	 * @param priority The priority to queue the event with.
+	 * @return A ticket to cancel the event with.
+	 *
+	 * @remarks Events with a deadline are never written to a spill.
+	 */
+	template <typename E, EventType EType = std::remove_cvref_t<E>>
+	EventQueue::Ticket queueEventUntil(E&& event, EventDeadline deadline,
+		EventPriority priority = EventPriority::Normal)
+	{
+		MARSCHALL_TRACE2(queue, eventTypeKey<EType>(), queueDepth());
+		EventQueue* queue = &eventQueue;
+		if (priority != EventPriority::Normal)
+			queue = &priorityQueue(priority);
+		else if (spilling())
+			queue = &pinned;
+
+		queue->emplaceUntil<EType>(eventTypeKey<EType>(), deadline, std::forward<E>(event));
+		if (queue == &pinned)
+			markPinned();
+		return queue->back();
+	}
+
+	/*
+	 * Queue an event that is dropped instead of delivered if it is still queued after a time to live.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 * @param timeToLive How long the event may wait in the queue.
+	 * @param priority The priority to queue the event with.
+	 * @return A ticket to cancel the event with.
+	 */
+	template <typename E, typename Rep, typename Period, EventType EType = std::remove_cvref_t<E>>
+	EventQueue::Ticket queueEventFor(E&& event, std::chrono::duration<Rep, Period> timeToLive,
+		EventPriority priority = EventPriority::Normal)
+	{
+		return queueEventUntil<E, EType>(std::forward<E>(event),
+			std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeToLive),
+			priority);
+	}
+
+	/*
+	 * Number of events of a type dropped by processQueue because their deadline passed.
+	 *
+	 * @tparam EType The event type.
+	 */
+	template <EventType EType>
+	std::size_t expiredCount() const
+	{
+		auto it = expiredEvents.find(eventTypeKey<EType>());
+		return it != expiredEvents.end() ? it->second : 0;
+	}
+
+	/*
+	 * Share processing between priorities so that low priorities are not starved.
+	 *
+	 * Each priority with a weight delivers at most that many events before lower priorities holding events get
+	 * their turn, then all shares are renewed. Priorities with weight zero are always served first.
+	 *
+	 * @param weights Weight of each priority, indexed by EventPriority. All zero, the default, drains higher
+	 *                priorities completely before lower ones.
+	 */
+	void setPriorityWeights(const std::array<std::uint32_t, eventPriorityLevels>& weights)
+	{
+		priorityWeights = weights;
+		priorityCredits = weights;
+	}
+
+	/*
+	 * Cancel a queued event before it is processed.
+	 *
+	 * The event is destroyed right away and skipped by processQueue, cancelling takes constant time.
+	 *
+	 * @param ticket The ticket returned when the event was queued.
+	 * @return False if the event was already processed or cancelled, or was written to a spill.
+	 */
+	bool cancel(const EventQueue::Ticket& ticket) noexcept
+	{
+		if (eventQueue.cancel(ticket) || pinned.cancel(ticket))
+			return true;
+		return std::ranges::any_of(priorityQueues, [&ticket](EventQueue& queue) { return queue.cancel(ticket); });
+	}
+
+	/*
+	 * Cancel all queued events of a type matching a predicate.
+	 *
+	 * @tparam EType The event type, events dispatched under other types are kept.
+	 * @param predicate Callable taking the event and returning true to cancel it.
+	 * @return The number of events cancelled, events written to a spill are not considered.
+	 */
+	template <EventType EType, typename Predicate>
+	std::size_t cancelIf(Predicate&& predicate)
+	{
+		auto matches = [&predicate](EventTypeKey key, void* event) {
+			return key == eventTypeKey<EType>() && predicate(*static_cast<const EType*>(event));
+			};
+		std::size_t cancelled = eventQueue.cancelIf(matches) + pinned.cancelIf(matches);
+		for (EventQueue& queue : priorityQueues)
+			cancelled += queue.cancelIf(matches);
+		return cancelled;
+	}
+
+	/*
+	 * Move all events of a queue to the back of the dispatcher's queue, keeping their order.
+	 *
+	 * Events are handed over without copying them, which lets events collected elsewhere, for example on
+	 * another thread, be queued in one step.
+	 *
+	 * @param events The events to queue, left empty.
+	 */
+	void queueEvents(EventQueue& events)
+	{
+		if (!spilling())
+		{
+			eventQueue.splice(events);
+			return;
+		}
+
+		std::size_t count = events.size();
+		pinned.splice(events);
+		for (std::size_t i = 0; i < count; ++i)
+			markPinned();
+	}
+
+	/*
+	 * Let queued events overflow into a spill once the in-memory queue exceeds a budget.
+	 *
+	 * While events are spilled, serializable events are written to the spill and read back in order by
+	 * processQueue. Other events stay in memory, ordered among the spilled ones.
+	 *
+	 * @param spill The spill to use, or nullptr to keep all queued events in memory.
+	 * @param memoryBudget Bytes of queue storage after which events are spilled.
+	 *
+	 * @remarks Set the spill while the queue is empty, events held by a replaced spill are lost.
+	 */
+	void setSpill(std::shared_ptr<IEventSpill> spill, std::size_t memoryBudget)
+	{
+		eventSpill = std::move(spill);
+		spillBudget = memoryBudget;
+		spilled = 0;
+	}
+
+	/*
+	 * Attach a queue that signal handlers and other lock-free contexts push events into.
+	 *
+	 * processQueue delivers the events of this queue before all other queued events.
+	 *
+	 * @param queue The queue, or nullptr to detach it.
+	 */
+	void setSignalQueue(std::shared_ptr<SignalEventQueue> queue)
+	{
+		signalQueue = std::move(queue);
+	}
+
+	/*
+	 * Process all queued events, dispatching them to their subscribed listeners.
+	 *
+	 * Events of the signal queue come first, then events by priority. Events queued while processing are
+	 * processed in the same call, an event of higher priority is delivered before the next one of lower priority.
+	 *
+	 * This blocks until all queued events have been processed.
+	 */
+	void processQueue()
+	{
+		MARSCHALL_TRACE1(process__entry, queueDepth());
+
+		if (signalQueue)
+			signalQueue->drain([this](EventTypeKey key, void* event) { deliver(key, event, true); });
+
+		while (processNext())
+		{
+		}
+
+		if (!batches.empty())
+			closeBatches(false);
+		if (sweepBudget != 0)
+			sweepExpired(sweepBudget);
+
+		MARSCHALL_TRACE1(process__exit, queueDepth());
+	}
+
+private:
+	/// Notifies a listener and returns whether it is still subscribed. Called with nullptr, it only checks that.
+	using Callback = std::function<bool(const void*)>;
+
+	/// Decodes and delivers a spilled event, stored at the start of each spill record. Null for pinned events.
+	using SpillReplay = void (*)(EventDispatcher&, std::span<const std::byte>);
+
+	EventQueue& priorityQueue(EventPriority priority) noexcept
+	{
+		return priorityQueues[static_cast<std::size_t>(priority) - (priority > EventPriority::Normal ? 1 : 0)];
+	}
+
+	/*
+	 * Deliver the next queued event of the highest priority that still has a share.
+	 *
+	 * @return False if no events are queued.
+	 */
+	bool processNext()
+	{
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (std::size_t level = eventPriorityLevels; level-- > 0;)
+			{
+				bool weighted = priorityWeights[level] != 0;
+				if (weighted && priorityCredits[level] == 0)
+					continue;
+				if (!processOne(static_cast<EventPriority>(level)))
+					continue;
+				if (weighted)
+					--priorityCredits[level];
+				return true;
+			}
+			priorityCredits = priorityWeights;
+		}
+		return false;
+	}
+
+	/// Deliver the next queued event of a priority, false if there is none.
+	bool processOne(EventPriority priority)
+	{
+		auto deliverOwned = [this](EventTypeKey key, void* event) {
+			deliver(key, event, true);
+			};
+		auto expire = [this](EventTypeKey key) {
+			++expiredEvents[key];
+			};
+
+		if (priority != EventPriority::Normal)
+			return priorityQueue(priority).consumeOne(deliverOwned, expire);
+
+		if (eventQueue.consumeOne(deliverOwned, expire))
+			return true;
+
+		if (spilled != 0)
+		{
+			std::span<const std::byte> record = eventSpill->read();
+			--spilled;
+			if (record.size() >= sizeof(SpillReplay))
+			{
+				SpillReplay replay;
+				std::memcpy(&replay, record.data(), sizeof(replay));
+				if (replay)
+					replay(*this, record.subspan(sizeof(SpillReplay)));
+				else
+					pinned.consumeOne(deliverOwned, expire);
+			}
+			return true;
+		}
+
+		if (!pinned.empty())
+		{
+			// Pinned events without a position in the spill, events queued meanwhile must go behind them.
+			spillBlocked = true;
+			pinned.consumeOne(deliverOwned, expire);
+			if (pinned.empty())
+				spillBlocked = false;
+			return true;
+		}
+
+		// Drop pinned events cancelled after their position in the spill was read.
+		pinned.clear();
+		return false;
+	}
+
+	/// Whether queued events must go behind the spilled ones.
+	bool spilling() const noexcept
+	{
+		return eventSpill && (spilled != 0 || !pinned.empty() || eventQueue.byteSize() >= spillBudget);
+	}
+
+	template <EventType EType, typename... Args>
+	EventQueue::Ticket enqueue(Args&&... args)
+	{
+		MARSCHALL_TRACE2(queue, eventTypeKey<EType>(), queueDepth());
+		if (!spilling())
+		{
+			eventQueue.emplace<EType>(eventTypeKey<EType>(), std::forward<Args>(args)...);
+			return eventQueue.back();
+		}
+
+		if constexpr (SerializableEvent<EType>)
+		{
+			if (!spillBlocked)
+			{
+				EType event(std::forward<Args>(args)...);
+				if (spillEvent(event))
+					return {};
+
+				pinned.emplace<EType>(eventTypeKey<EType>(), std::move(event));
+				spillBlocked = true;
+				return pinned.back();
+			}
+		}
+
+		pinned.emplace<EType>(eventTypeKey<EType>(), std::forward<Args>(args)...);
+		markPinned();
+		return pinned.back();
+	}
+
+	template <SerializableEvent EType>
+	bool spillEvent(const EType& event)
+	{
+		SpillReplay replay = &replaySpilled<EType>;
+		spillRecord.resize(sizeof(replay));
+		std::memcpy(spillRecord.data(), &replay, sizeof(replay));
+		EventCodec<EType>::encode(event, spillRecord);
+
+		if (!eventSpill->write(spillRecord))
+			return false;
+		++spilled;
+		return true;
+	}
+
+	template <SerializableEvent EType>
+	static void replaySpilled(EventDispatcher& dispatcher, std::span<const std::byte> payload)
+	{
+		if (std::optional<EType> event = EventCodec<EType>::decode(payload))
+			dispatcher.deliver(eventTypeKey<EType>(), &*event, true);
+	}
+
+	/*
+	 * Record the position of the most recently pinned event among the spilled ones.
+	 *
+	 * If the spill fails, later events are pinned without a position and delivered after all spilled events.
+	 */
+	void markPinned()
+	{
+		if (spillBlocked)
+			return;
+
+		SpillReplay replay = nullptr;
+		spillRecord.resize(sizeof(replay));
+		std::memcpy(spillRecord.data(), &replay, sizeof(replay));
+		if (eventSpill->write(spillRecord))
+			++spilled;
+		else
+			spillBlocked = true;
+	}
+
+	struct Identity
+	{
+		EventTypeKey key;
+		const void* object;
+	};
+
+	/*
+	 * Determine the type key an event is dispatched under, and the address of the object of that type.
+	 *
+	 * Events deriving from EventBase are identified by their concrete type. Other events deriving from Event are
+	 * identified by their concrete type through RTTI if it is available, which only finds types something was
+	 * subscribed to, see channelKey. All others are identified by their static type.
+	 */
+	template <EventType EType>
+	Identity identify(const EType& event) const
+	{
+		if constexpr (PolymorphicEventType<EType>)
+		{
+			if (EventTypeKey key = event.getTypeKey())
+				return { key, dynamic_cast<const void*>(&event) };
+#if defined(__cpp_rtti)
+			if (typeid(event) != typeid(EType))
+			{
+				auto it = runtimeTypes.find(std::type_index(typeid(event)));
+				return { it != runtimeTypes.end() ? it->second : nullptr, dynamic_cast<const void*>(&event) };
+			}
+#else
+			assert((!std::is_same_v<EType, Event>)
+				&& "events dispatched or queued through Event must derive from EventBase without RTTI");
+#endif
+		}
+
+		return { eventTypeKey<EType>(), &event };
+	}
+
+	/*
+	 * Key of the channel of an event type, remembering the type for identify.
+	 *
+	 * Events deriving from Event but not from EventBase don't know their key, with RTTI they are routed through
+	 * the types subscribed to here when dispatched or queued through a base class.
+	 */
+	template <EventType EType>
+	EventTypeKey channelKey()
+	{
+#if defined(__cpp_rtti)
+		if constexpr (PolymorphicEventType<EType>)
+			runtimeTypes.try_emplace(std::type_index(typeid(EType)), eventTypeKey<EType>());
+#endif
+		return eventTypeKey<EType>();
+	}
+
+	template <EventType EType>
+	void unsubscribeFrom(const EventListener<EType>* id)
+	{
+		unsubscribe(eventTypeKey<EType>(), id);
+	}
+
+	void unsubscribe(EventTypeKey key, const IEventListener* id)
+	{
+		auto it = channels.find(key);
+		if (it == channels.end())
+			return;
+
+		Channel& channel = it->second;
+		auto sub = channel.subscribers.find(id);
+		if (sub == channel.subscribers.end())
+			return;
+
+		MARSCHALL_TRACE2(unsubscribe, key, sub->id);
+		if (channel.notifying != 0)
+		{
+			// Notifications in progress still point at the subscriber, it is skipped and erased once they are done.
+			sub->expired = true;
+			channel.pendingErase = true;
+		}
+		else
+		{
+			channel.subscribers.erase(sub);
+			channel.dirty = true;
+		}
+	}
+
+	/*
+	 * Deliver batches whose window is over, and drop batches of expired listeners.
+	 *
+	 * @param force Whether to deliver all collected events regardless of their windows.
+	 */
+	void closeBatches(bool force)
+	{
+		bool expired = false;
+		for (std::size_t i = 0; i < batches.size(); ++i)
+		{
+			// Held while delivering, the listener may unsubscribe itself.
+			std::shared_ptr<IEventBatch> batch = batches[i];
+			if (!batch->flush(force))
+				expired = true;
+		}
+
+		if (expired)
+			std::erase_if(batches, [](const std::shared_ptr<IEventBatch>& batch) { return batch->expired(); });
+	}
+
+	struct Subscriber
+	{
+		const IEventListener* id;
+		Callback callback;
+		std::vector<const IEventListener*> after;
+		mutable bool expired = false;
+		/// Watchdog state, only written by the task notifying this subscriber.
+		mutable bool quarantined = false;
+		mutable std::uint32_t violations = 0;
+		mutable std::chrono::nanoseconds worst{ 0 };
+	};
+
+	struct SubscriberHash {
+		using is_transparent = void;
+		std::size_t operator()(const Subscriber& s) const noexcept {
+			return std::hash<const IEventListener*>{}(s.id);
+		}
+		std::size_t operator()(const IEventListener* id) const noexcept {
+			return std::hash<const IEventListener*>{}(id);
+		}
+	};
+	struct SubscriberEqual {
+		using is_transparent = void;
+		bool operator()(const Subscriber& lhs, const Subscriber& rhs) const noexcept {
+			return lhs.id == rhs.id;
+		}
+		bool operator()(const Subscriber& lhs, const IEventListener* rhs) const noexcept {
+			return lhs.id == rhs;
+		}
+		bool operator()(const IEventListener* lhs, const Subscriber& rhs) const noexcept {
+			return lhs == rhs.id;
+		}
+	};
+
+	enum class Response
+	{
+		Continue,
+		Satisfied,
+		Expired
+	};
+
+	/// Receives results of a known type on behalf of a reducer of unknown type.
+	template <typename Result>
+	struct ResultSink
+	{
+		virtual bool accept(Result&& result) = 0;
+
+	protected:
+		~ResultSink() = default;
+	};
+
+	template <typename Result, typename Reducer>
+	struct ReducerSink final : ResultSink<Result>
+	{
+		explicit ReducerSink(Reducer& reducer) : reducer(reducer) {}
+
+		bool accept(Result&& result) override
+		{
+			return reducer.add(std::move(result));
+		}
+
+		Reducer& reducer;
+	};
+
+	struct Responder
+	{
+		const IEventListener* id;
+		std::function<Response(const void*, void*)> respond;
+	};
+
+	struct Consumer
+	{
+		const IEventListener* id = nullptr;
+		std::function<bool(const void*, bool)> consume;
+	};
+
+	/// Everything the dispatcher holds for a single event type.
+	struct Channel
+	{
+		std::unordered_set<Subscriber, SubscriberHash, SubscriberEqual> subscribers;
+		std::shared_ptr<IEventStream> stream;
+		std::vector<Responder> responders;
+		Consumer consumer;
+
+		/// Subscribers in topological order, rebuilt lazily whenever subscriptions change.
+		std::vector<const Subscriber*> order;
+		/// Indices into order of the subscribers running after each subscriber.
+		std::vector<std::vector<std::size_t>> successors;
+		/// Number of subscribers each subscriber runs after.
+		std::vector<std::size_t> predecessors;
+		std::unique_ptr<std::atomic<std::size_t>[]> remaining;
+		bool dirty = false;
+		/// Number of notifications of this channel in progress. Subscribers are only erased while it is zero.
+		std::size_t notifying = 0;
+		/// Whether subscribers marked expired wait to be erased.
+		bool pendingErase = false;
+		/// Dispatches left until the watchdog times the next one.
+		std::uint32_t untilSample = 0;
+	};
+
+	/*
+	 * State shared by the tasks of a single parallel notification.
+	 */
+	struct ParallelNotification
+	{
+		Channel& channel;
+		EventTypeKey key;
+		const void* event;
+		const ListenerWatchdog* watchdog;
+		ThreadPool& pool;
+		std::latch done;
+		std::atomic<std::size_t> expired{ 0 };
+
+		void run(std::size_t index)
+		{
+			const Subscriber& subscriber = *channel.order[index];
+			MARSCHALL_TRACE2(listener, key, subscriber.id);
+			if (!notifyOne(subscriber, event, watchdog))
+			{
+				subscriber.expired = true;
+				expired.fetch_add(1, std::memory_order_relaxed);
+			}
+
+			for (std::size_t next : channel.successors[index])
+				if (channel.remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+					pool.submit([this, next] { run(next); });
+
+			done.count_down();
+		}
+	};
+
+	/// Number of events waiting to be processed, for tracing.
+	std::size_t queueDepth() const noexcept
+	{
+		std::size_t depth = eventQueue.size() + pinned.size() + spilled;
+		for (const EventQueue& queue : priorityQueues)
+			depth += queue.size();
+		return depth;
+	}
+
+	Channel* observedChannel(EventTypeKey key)
+	{
+		auto it = channels.find(key);
+		if (it == channels.end())
+			return nullptr;
+
+		Channel& channel = it->second;
+		if (channel.subscribers.empty() && !channel.consumer.consume && !(channel.stream && channel.stream->hasReaders()))
+			return nullptr;
+		return &channel;
+	}
+
+	/*
+	 * Check whether a static or dynamic subscriber observes an event type.
+	 *
+	 * @param channel Set to the channel of the type if it is observed dynamically, nullptr otherwise.
+	 */
+	bool observed(EventTypeKey key, Channel*& channel)
+	{
+		channel = observedChannel(key);
+		return channel || (staticTopology && staticTopology->observes(key));
+	}
+
+	void deliver(EventTypeKey key, const void* event, bool owned = false)
+	{
+		auto it = channels.find(key);
+		deliver(it != channels.end() ? &it->second : nullptr, key, event, owned);
+	}
+
+	/// Notify the static subscribers of an event, then the channel of its type if there is one.
+	void deliver(Channel* channel, EventTypeKey key, const void* event, bool owned)
+	{
+		MARSCHALL_TRACE1(dispatch__entry, key);
+		if (staticTopology)
+			staticTopology->dispatch(key, event);
+		if (channel)
+			notify(*channel, key, event, owned);
+		MARSCHALL_TRACE1(dispatch__exit, key);
+	}
+
+	void subscribe(EventTypeKey key, Subscriber&& subscriber)
+	{
+		MARSCHALL_TRACE2(subscribe, key, subscriber.id);
+		auto& channel = channels[key];
+		auto [it, inserted] = channel.subscribers.emplace(std::move(subscriber));
+		if (inserted)
+			channel.dirty = true;
+		else
+			it->expired = false;
+	}
+
+	/*
+	 * Rebuild the topological order of a channel's subscribers.
+	 *
+	 * Edges pointing backwards in the resulting order, which only exist for cycles, are dropped.
+	 */
+	static void sortSubscribers(Channel& channel)
+	{
+		const std::size_t count = channel.subscribers.size();
+
+		std::vector<const Subscriber*> nodes;
+		nodes.reserve(count);
+		std::unordered_map<const IEventListener*, std::size_t> indices;
+		for (const Subscriber& subscriber : channel.subscribers)
+		{
+			indices.emplace(subscriber.id, nodes.size());
+			nodes.push_back(&subscriber);
+		}
+
+		std::vector<std::vector<std::size_t>> next(count);
+		std::vector<std::size_t> incoming(count, 0);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			for (const IEventListener* dependency : nodes[i]->after)
+			{
+				auto it = indices.find(dependency);
+				if (it != indices.end() && it->second != i)
+				{
+					next[it->second].push_back(i);
+					++incoming[i];
+				}
+			}
+		}
+
+		std::vector<std::size_t> sorted;
+		sorted.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+			if (incoming[i] == 0)
+				sorted.push_back(i);
+		for (std::size_t head = 0; head < sorted.size(); ++head)
+			for (std::size_t successor : next[sorted[head]])
+				if (--incoming[successor] == 0)
+					sorted.push_back(successor);
+		for (std::size_t i = 0; i < count; ++i)
+			if (incoming[i] != 0)
+				sorted.push_back(i);
+
+		std::vector<std::size_t> position(count);
+		for (std::size_t i = 0; i < count; ++i)
+			position[sorted[i]] = i;
+
+		channel.order.resize(count);
+		channel.successors.assign(count, {});
+		channel.predecessors.assign(count, 0);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			channel.order[position[i]] = nodes[i];
+			for (std::size_t successor : next[i])
+			{
+				if (position[i] < position[successor])
+				{
+					channel.successors[position[i]].push_back(position[successor]);
+					++channel.predecessors[position[successor]];
+				}
+			}
+		}
+		channel.remaining = std::make_unique<std::atomic<std::size_t>[]>(count);
+		channel.dirty = false;
+	}
+
+	/*
+	 * Notify everyone observing an event.
+	 *
+	 * @param owned Whether the dispatcher may move out of the event once the listeners are done.
+	 */
+	void notify(Channel& channel, EventTypeKey key, const void* event, bool owned = false)
+	{
+		if (channel.stream)
+			channel.stream->append(event);
+
+		if (!channel.subscribers.empty())
+		{
+			// Notifications in progress iterate the order, subscribers added meanwhile are notified from the next one on.
+			if (channel.dirty && channel.notifying == 0)
+				sortSubscribers(channel);
+
+			const ListenerWatchdog* watchdog = nullptr;
+			if (listenerWatchdog.budget.count() > 0)
+			{
+				if (channel.untilSample == 0)
+				{
+					channel.untilSample = listenerWatchdog.sampleInterval;
+					watchdog = &listenerWatchdog;
+				}
+				--channel.untilSample;
+			}
+
+			++channel.notifying;
+			std::size_t expired = threadPool && channel.order.size() > 1
+				? notifyParallel(channel, key, event, watchdog)
+				: notifySequential(channel, key, event, watchdog);
+			--channel.notifying;
+
+			if (expired != 0)
+				channel.pendingErase = true;
+			if (channel.pendingErase && channel.notifying == 0)
+			{
+				std::erase_if(channel.subscribers, [](const Subscriber& s) {
+					return s.expired;
+					});
+				channel.pendingErase = false;
+				channel.dirty = true;
+			}
+		}
+
+		if (channel.consumer.consume && !channel.consumer.consume(event, owned))
+			channel.consumer = {};
+	}
+
+	/*
+	 * Notify a single subscriber unless it is quarantined or already expired.
+	 *
+	 * @param watchdog The limits to time the notification against, nullptr if this dispatch is not sampled.
+	 * @return False if the subscriber expired during this notification.
+	 */
+	static bool notifyOne(const Subscriber& subscriber, const void* event, const ListenerWatchdog* watchdog)
+	{
+		if (subscriber.quarantined || subscriber.expired)
+			return true;
+		if (!watchdog)
+			return subscriber.callback(event);
+
+		auto start = std::chrono::steady_clock::now();
+		bool alive = subscriber.callback(event);
+		auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+		if (elapsed > watchdog->budget)
+		{
+			++subscriber.violations;
+			subscriber.worst = std::max(subscriber.worst, elapsed);
+			if (watchdog->quarantineAfter != 0 && subscriber.violations >= watchdog->quarantineAfter)
+				subscriber.quarantined = true;
+		}
+		return alive;
+	}
+
+	static std::size_t notifySequential(Channel& channel, EventTypeKey key, const void* event,
+		const ListenerWatchdog* watchdog)
+	{
+		std::size_t expired = 0;
+		for (const Subscriber* subscriber : channel.order)
+		{
+			MARSCHALL_TRACE2(listener, key, subscriber->id);
+			if (!notifyOne(*subscriber, event, watchdog))
+			{
+				subscriber->expired = true;
+				++expired;
+			}
+		}
+		return expired;
+	}
+
+	std::size_t notifyParallel(Channel& channel, EventTypeKey key, const void* event, const ListenerWatchdog* watchdog)
+	{
+		const std::size_t count = channel.order.size();
+		ParallelNotification notification{ channel, key, event, watchdog, *threadPool,
+			std::latch(static_cast<std::ptrdiff_t>(count)) };
+
+		std::size_t inlineRoot = count;
+		for (std::size_t i = 0; i < count; ++i)
+			channel.remaining[i].store(channel.predecessors[i], std::memory_order_relaxed);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (channel.predecessors[i] != 0)
+				continue;
+			if (inlineRoot == count)
+				inlineRoot = i;
+			else
+				threadPool->submit([&notification, i] { notification.run(i); });
+		}
+
+		notification.run(inlineRoot);
+		while (!notification.done.try_wait())
+			if (!threadPool->runPendingTask())
+				std::this_thread::yield();
+
+		return notification.expired.load(std::memory_order_relaxed);
+	}
+
+	const StaticTopology* staticTopology = nullptr;
+	std::unordered_map<EventTypeKey, Channel> channels;
+#if defined(__cpp_rtti)
+	/// Keys of the subscribed types deriving from Event but not from EventBase, by their RTTI.
+	std::unordered_map<std::type_index, EventTypeKey> runtimeTypes;
+#endif
+	/// Events of Normal priority.
+	EventQueue eventQueue;
+	/// Events of the other priorities, lowest first.
+	std::array<EventQueue, eventPriorityLevels - 1> priorityQueues;
+	std::array<std::uint32_t, eventPriorityLevels> priorityWeights{};
+	/// Events each weighted priority may still deliver before the shares are renewed.
+	std::array<std::uint32_t, eventPriorityLevels> priorityCredits{};
+	/// Number of events dropped per type because their deadline passed.
+	std::unordered_map<EventTypeKey, std::size_t> expiredEvents;
+
+	std::shared_ptr<SignalEventQueue> signalQueue;
+	/// Batches of all batch listeners, to close their windows.
+	std::vector<std::shared_ptr<IEventBatch>> batches;
+	ListenerWatchdog listenerWatchdog;
+	/// Type and hash bucket of its subscribers the next sweep of expired subscribers starts at.
+	EventTypeKey sweepCursor = nullptr;
+	std::size_t sweepBucket = 0;
+	/// Expired subscribers found by a sweep, kept to reuse its capacity.
+	std::vector<const IEventListener*> sweepExpiredIds;
+	std::size_t sweepBudget = 0;
+
+	std::shared_ptr<IEventSpill> eventSpill;
+	std::size_t spillBudget = 0;
+	/// Number of records in the spill written by this dispatcher.
+	std::size_t spilled = 0;
+	/// Events queued while spilling that can't be serialized, in order.
+	EventQueue pinned;
+	/// Set while pinned events are not marked in the spill, until the spill is drained.
+	bool spillBlocked = false;
+	std::vector<std::byte> spillRecord;
+	std::shared_ptr<ThreadPool> threadPool;
+};
\ No newline at end of file
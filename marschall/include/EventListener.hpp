@@ -1,5 +1,6 @@
 #pragma once
 #include "Event.hpp"
+#include <span>
 
 /*
  * Abstract base class for event listeners.
@@ -40,4 +41,52 @@ class MultiEventListener : public EventListener<EType>...
 {
 	public:
 	virtual ~MultiEventListener() = default;
+};
+
+/*
+ * Template for listeners taking ownership of events of a specific type.
+ *
+ * Inherit from EventConsumer<EType> to receive events by rvalue reference. A consumer is notified after all
+ * regular listeners have seen the event, so it may move out of it.
+ *
+ * @tparam EType The event type this consumer takes.
+ */
+template<EventType EType>
+class EventConsumer : public IEventListener
+{
+public:
+	virtual ~EventConsumer() = default;
+	virtual void onEvent(EType&& event) = 0;
+};
+
+/*
+ * Template for listeners receiving events of a specific type in batches.
+ *
+ * Inherit from BatchListener<EType> and subscribe with EventDispatcher::subscribeBatchTo to receive events
+ * collected over a window as one contiguous span, for example to write them in a single transaction.
+ *
+ * @tparam EType The event type this listener handles.
+ */
+template<EventType EType>
+class BatchListener : public IEventListener
+{
+public:
+	virtual ~BatchListener() = default;
+	virtual void onBatch(std::span<const EType> events) = 0;
+};
+
+/*
+ * Template for listeners answering queries of a specific type.
+ *
+ * Inherit from QueryListener<QType> to respond to requests of type QType.
+ * When a request is made, the onQuery method is called and its result handed to the request's reducer.
+ *
+ * @tparam QType The query type this listener answers.
+ */
+template <QueryType QType>
+class QueryListener : public IEventListener
+{
+public:
+	virtual ~QueryListener() = default;
+	virtual typename QType::Result onQuery(const QType& query) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,238 @@
+#pragma once
+#include "EventDispatcher.hpp"
+#include "EventQueue.hpp"
+#include <mutex>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <cerrno>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+/// Dispatched when a file descriptor watched by an EventLoop becomes ready.
+struct FileReadyEvent
+{
+	int fd;
+	/// The ready epoll events, such as EPOLLIN.
+	std::uint32_t events;
+};
+
+/*
+ * Blocking event loop around a dispatcher, built on epoll and an eventfd.
+ *
+ * Other threads queue events through the loop, the thread running the loop waits without spinning until events
+ * arrive or a watched file descriptor becomes ready, then processes them with the dispatcher.
+ *
+ * @remarks Only the thread calling waitAndProcess may use the dispatcher. queueEvent and wake may be called from
+ *          any thread. Requires Linux.
+ */
+class EventLoop
+{
+public:
+	/// Maximum number of ready file descriptors handled per wait.
+	static constexpr int maxReady = 64;
+
+	/// @param dispatcher The dispatcher processing the events, must outlive the loop.
+	explicit EventLoop(EventDispatcher& dispatcher)
+		: dispatcher(dispatcher),
+		epollFile(::epoll_create1(EPOLL_CLOEXEC)),
+		wakeFile(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+	{
+		if (epollFile == -1 || wakeFile == -1 || !control(EPOLL_CTL_ADD, wakeFile, EPOLLIN))
+			closeFiles();
+	}
+
+	EventLoop(const EventLoop&) = delete;
+	EventLoop& operator=(const EventLoop&) = delete;
+
+	~EventLoop()
+	{
+		closeFiles();
+	}
+
+	/// False if the epoll instance or the eventfd could not be created.
+	bool isOpen() const noexcept
+	{
+		return epollFile != -1;
+	}
+
+	/*
+	 * Queue an event from any thread, waking the loop if it is waiting.
+	 *
+	 * Only the first event queued since the loop last took the queued events signals the eventfd.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 */
+	template <typename E, EventType EType = std::remove_cvref_t<E>>
+	void queueEvent(E&& event)
+	{
+		queueEmplace<EType>(std::forward<E>(event));
+	}
+
+	/*
+	 * Construct an event in the queue from any thread, waking the loop if it is waiting.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param args The arguments to construct the event from.
+	 */
+	template <EventType EType, typename... Args>
+	void queueEmplace(Args&&... args)
+	{
+		bool wasEmpty;
+		{
+			std::lock_guard lock(mutex);
+			wasEmpty = inbox.empty();
+			inbox.emplace<EType>(eventTypeKey<EType>(), std::forward<Args>(args)...);
+		}
+		if (wasEmpty)
+			wake();
+	}
+
+	/*
+	 * Move all events of a queue to the loop from any thread, keeping their order.
+	 *
+	 * The events become visible to the loop's thread together, no event queued by another thread ends up
+	 * between them.
+	 *
+	 * @param events The events to queue, left empty.
+	 */
+	void queueEvents(EventQueue& events)
+	{
+		if (events.empty())
+			return;
+
+		bool wasEmpty;
+		{
+			std::lock_guard lock(mutex);
+			wasEmpty = inbox.empty();
+			inbox.splice(events);
+		}
+		if (wasEmpty)
+			wake();
+	}
+
+	/// Interrupt a wait of the loop from any thread.
+	void wake() noexcept
+	{
+		std::uint64_t one = 1;
+		while (::write(wakeFile, &one, sizeof(one)) < 0 && errno == EINTR)
+		{
+		}
+	}
+
+	/*
+	 * Watch a file descriptor, dispatching a FileReadyEvent whenever it is ready.
+	 *
+	 * @param fd The file descriptor, such as a socket or timerfd. It is not closed by the loop.
+	 * @param events The epoll events to wait for.
+	 * @return False if the descriptor could not be watched.
+	 */
+	bool watch(int fd, std::uint32_t events = EPOLLIN)
+	{
+		return watch(fd, events, [](EventDispatcher& dispatcher, int fd, std::uint32_t ready) {
+			dispatcher.dispatch(FileReadyEvent{ fd, ready });
+			});
+	}
+
+	/*
+	 * Watch a file descriptor, calling a handler whenever it is ready.
+	 *
+	 * Use this to turn readiness into events of your own, for example by reading the descriptor and
+	 * dispatching what was read.
+	 *
+	 * @param fd The file descriptor. It is not closed by the loop.
+	 * @param events The epoll events to wait for.
+	 * @param handler Called on the loop's thread with the dispatcher, the descriptor and the ready events.
+	 * @return False if the descriptor could not be watched.
+	 */
+	bool watch(int fd, std::uint32_t events, std::function<void(EventDispatcher&, int, std::uint32_t)> handler)
+	{
+		bool watched = sources.contains(fd);
+		if (!control(watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, events))
+			return false;
+		sources[fd] = std::make_shared<Handler>(std::move(handler));
+		return true;
+	}
+
+	/// Stop watching a file descriptor.
+	void unwatch(int fd)
+	{
+		if (sources.erase(fd) != 0)
+			::epoll_ctl(epollFile, EPOLL_CTL_DEL, fd, nullptr);
+	}
+
+	/*
+	 * Wait until events are queued or a watched descriptor is ready, then process them.
+	 *
+	 * Events queued from other threads are moved to the dispatcher's queue, then the dispatcher's queue is processed.
+	 *
+	 * @param timeoutMilliseconds Maximum time to wait, 0 to return immediately and -1 to wait indefinitely.
+	 * @return The number of ready sources handled, 0 on timeout.
+	 */
+	std::size_t waitAndProcess(int timeoutMilliseconds = -1)
+	{
+		if (epollFile == -1)
+			return 0;
+
+		epoll_event ready[maxReady];
+		int count = ::epoll_wait(epollFile, ready, maxReady, timeoutMilliseconds);
+		if (count <= 0)
+			return 0;
+
+		for (int i = 0; i < count; ++i)
+		{
+			int fd = ready[i].data.fd;
+			if (fd == wakeFile)
+			{
+				std::uint64_t value;
+				while (::read(wakeFile, &value, sizeof(value)) < 0 && errno == EINTR)
+				{
+				}
+
+				std::lock_guard lock(mutex);
+				dispatcher.queueEvents(inbox);
+			}
+			else if (auto it = sources.find(fd); it != sources.end())
+			{
+				std::shared_ptr<Handler> handler = it->second;
+				(*handler)(dispatcher, fd, ready[i].events);
+			}
+		}
+
+		dispatcher.processQueue();
+		return static_cast<std::size_t>(count);
+	}
+
+private:
+	using Handler = std::function<void(EventDispatcher&, int, std::uint32_t)>;
+
+	bool control(int operation, int fd, std::uint32_t events) noexcept
+	{
+		epoll_event event{};
+		event.events = events;
+		event.data.fd = fd;
+		return ::epoll_ctl(epollFile, operation, fd, &event) == 0;
+	}
+
+	void closeFiles() noexcept
+	{
+		if (wakeFile != -1)
+			::close(wakeFile);
+		if (epollFile != -1)
+			::close(epollFile);
+		wakeFile = epollFile = -1;
+	}
+
+	EventDispatcher& dispatcher;
+	int epollFile;
+	int wakeFile;
+	/// Handlers are shared so they stay alive if they unwatch their own descriptor.
+	std::unordered_map<int, std::shared_ptr<Handler>> sources;
+
+	std::mutex mutex;
+	/// Events queued by other threads, moved to the dispatcher's queue in one step.
+	EventQueue inbox;
+};
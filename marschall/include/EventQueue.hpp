@@ -0,0 +1,540 @@
+#pragma once
+#include "Event.hpp"
+#include <memory>
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+
+/// Point in time after which a queued event is no longer delivered.
+using EventDeadline = std::chrono::steady_clock::time_point;
+
+/*
+ * FIFO queue storing events of any type by value in reusable chunks of contiguous memory.
+ *
+ * Trivially copyable events are copied with memcpy, other events are constructed in place.
+ * Events handed over as unique pointers are stored as the pointer.
+ * Each event is stored together with the type key it is dispatched under.
+ * Queued events can be cancelled in place, leaving a tombstone that consuming skips.
+ * Events queued with a deadline are dropped instead of consumed once their deadline passed.
+ */
+class EventQueue
+{
+	struct Chunk;
+
+public:
+	/// Default number of bytes per chunk, larger events get a chunk of their own.
+	static constexpr std::size_t chunkSize = 4096;
+
+	/// Identifies a queued event for cancellation, see back and cancel.
+	struct Ticket
+	{
+		const EventQueue* queue = nullptr;
+		Chunk* chunk = nullptr;
+		std::size_t offset = 0;
+		/// Number of records pushed to the queue before this one.
+		std::uint64_t position = 0;
+	};
+
+	EventQueue() = default;
+	EventQueue(const EventQueue&) = delete;
+	EventQueue& operator=(const EventQueue&) = delete;
+
+	~EventQueue()
+	{
+		clear();
+	}
+
+	/*
+	 * Construct an event in place at the back of the queue.
+	 *
+	 * @tparam EType The event type.
+	 * @param key The type key the event is dispatched under.
+	 * @param args The arguments to construct the event from.
+	 */
+	template <EventType EType, typename... Args>
+	void emplace(EventTypeKey key, Args&&... args)
+	{
+		if constexpr (alignof(EType) > alignof(std::max_align_t))
+		{
+			void* payload = allocate(key, boxedOps<EType>, sizeof(EType*), alignof(EType*));
+			new (payload) EType*(new EType(std::forward<Args>(args)...));
+		}
+		else if constexpr (std::is_trivially_copyable_v<EType> && sizeof...(Args) == 1
+			&& (std::is_same_v<std::remove_cvref_t<Args>, EType> && ...))
+		{
+			void* payload = allocate(key, valueOps<EType>, sizeof(EType), alignof(EType));
+			copyBytes<EType>(payload, args...);
+		}
+		else
+		{
+			void* payload = allocate(key, valueOps<EType>, sizeof(EType), alignof(EType));
+			new (payload) EType(std::forward<Args>(args)...);
+		}
+	}
+
+	/*
+	 * Construct an event in place at the back of the queue, to be dropped if consumed after a deadline.
+	 *
+	 * @tparam EType The event type.
+	 * @param key The type key the event is dispatched under.
+	 * @param deadline The point in time after which the event is dropped.
+	 * @param args The arguments to construct the event from.
+	 */
+	template <EventType EType, typename... Args>
+	void emplaceUntil(EventTypeKey key, EventDeadline deadline, Args&&... args)
+	{
+		if constexpr (alignof(EType) > alignof(std::max_align_t))
+		{
+			void* payload = allocate(key, timedBoxedOps<EType>, sizeof(Timed<EType*>), alignof(Timed<EType*>));
+			new (payload) Timed<EType*>{ deadline, new EType(std::forward<Args>(args)...) };
+		}
+		else
+		{
+			void* payload = allocate(key, timedOps<EType>, sizeof(Timed<EType>), alignof(Timed<EType>));
+			new (payload) Timed<EType>{ deadline, EType(std::forward<Args>(args)...) };
+		}
+	}
+
+	/*
+	 * Store an event owned by a unique pointer at the back of the queue.
+	 *
+	 * @param key The type key the event is dispatched under.
+	 * @param event The event to store.
+	 * @param object Address of the object of the type identified by key within the event.
+	 */
+	template <EventType EType>
+	void push(EventTypeKey key, std::unique_ptr<EType> event, void* object)
+	{
+		void* payload = allocate(key, ownedOps<EType>, sizeof(Owned<EType>), alignof(Owned<EType>));
+		new (payload) Owned<EType>{ std::move(event), object };
+	}
+
+	/*
+	 * Remove events from the front of the queue, passing each to a callback.
+	 *
+	 * Events pushed by the callback are consumed in the same call.
+	 *
+	 * @param f Callable invoked with the type key and a pointer to the event.
+	 *
+	 * @remarks The event is destroyed once the callback returns, so the callback may move out of it.
+	 */
+	template <typename F>
+	void consume(F&& f)
+	{
+		while (consumeOne(f))
+		{
+		}
+	}
+
+	/*
+	 * Remove the event at the front of the queue, passing it to a callback.
+	 *
+	 * A cancelled event is removed without invoking the callback.
+	 *
+	 * @param f Callable invoked with the type key and a pointer to the event.
+	 * @return False if the queue was empty.
+	 */
+	template <typename F>
+	bool consumeOne(F&& f)
+	{
+		return consumeOne(f, [](EventTypeKey) {});
+	}
+
+	/*
+	 * Remove the event at the front of the queue, passing it to a callback unless its deadline passed.
+	 *
+	 * @param f Callable invoked with the type key and a pointer to the event.
+	 * @param expire Callable invoked with the type key of an event dropped because its deadline passed.
+	 * @return False if the queue was empty.
+	 */
+	template <typename F, typename Expire>
+	bool consumeOne(F&& f, Expire&& expire)
+	{
+		while (!chunks.empty())
+		{
+			Chunk& chunk = *chunks.front();
+			if (chunk.head == chunk.tail)
+			{
+				if (chunks.size() == 1)
+				{
+					chunk.head = chunk.tail = 0;
+					return false;
+				}
+				recycleFront();
+				continue;
+			}
+
+			Record& record = chunk.record(chunk.head);
+			void* payload = chunk.data() + record.payload;
+			const Ops* ops = record.ops;
+			if (ops != &tombstoneOps)
+			{
+				// Mark the event as consumed before delivering it, so the callback cannot cancel it.
+				record.ops = &tombstoneOps;
+				--count;
+				if (ops->deadline && ops->deadline(payload) < std::chrono::steady_clock::now())
+					expire(record.key);
+				else
+					f(record.key, ops->object(payload));
+				if (ops->destroy)
+					ops->destroy(payload);
+			}
+			usedBytes -= record.end - chunk.head;
+			chunk.head = record.end;
+			++popped;
+			return true;
+		}
+		return false;
+	}
+
+	/*
+	 * Move all events of another queue to the back of this queue, keeping their order.
+	 *
+	 * Events are not copied, the other queue's chunks are handed over.
+	 *
+	 * @param other The queue to take the events from, left empty.
+	 */
+	void splice(EventQueue& other)
+	{
+		if (&other == this || other.pushed == other.popped)
+			return;
+
+		for (std::unique_ptr<Chunk>& chunk : other.chunks)
+			chunks.push_back(std::move(chunk));
+		other.chunks.clear();
+
+		count += other.count;
+		usedBytes += other.usedBytes;
+		pushed += other.pushed - other.popped;
+		lastRecord = other.lastRecord;
+		other.count = 0;
+		other.usedBytes = 0;
+		other.popped = other.pushed;
+	}
+
+	/*
+	 * Identify the most recently pushed event, to cancel it later.
+	 *
+	 * @return A ticket for the event at the back, only valid while the queue is not empty.
+	 *
+	 * @remarks Events spliced into another queue can no longer be cancelled through their tickets.
+	 */
+	Ticket back() noexcept
+	{
+		return Ticket{ this, chunks.back().get(), lastRecord, pushed - 1 };
+	}
+
+	/*
+	 * Destroy a queued event in place, consuming skips it.
+	 *
+	 * Takes constant time, the event's storage is reclaimed once consuming reaches it.
+	 *
+	 * @param ticket The ticket of the event.
+	 * @return False if the event was already consumed, cancelled or belongs to another queue.
+	 */
+	bool cancel(const Ticket& ticket) noexcept
+	{
+		if (ticket.queue != this || ticket.position < popped || ticket.position >= pushed)
+			return false;
+
+		return tombstone(ticket.chunk->record(ticket.offset), *ticket.chunk);
+	}
+
+	/*
+	 * Cancel all queued events matching a predicate.
+	 *
+	 * @param predicate Callable invoked with the type key and a pointer to each event, returning true to cancel it.
+	 * @return The number of events cancelled.
+	 */
+	template <typename Predicate>
+	std::size_t cancelIf(Predicate&& predicate)
+	{
+		std::size_t cancelled = 0;
+		for (const std::unique_ptr<Chunk>& chunk : chunks)
+		{
+			for (std::size_t offset = chunk->head; offset != chunk->tail;)
+			{
+				Record& record = chunk->record(offset);
+				offset = record.end;
+				if (record.ops != &tombstoneOps
+					&& predicate(record.key, record.ops->object(chunk->data() + record.payload)))
+				{
+					tombstone(record, *chunk);
+					++cancelled;
+				}
+			}
+		}
+		return cancelled;
+	}
+
+	/// Destroy all queued events.
+	void clear() noexcept
+	{
+		consume([](EventTypeKey, void*) {});
+	}
+
+	bool empty() const noexcept
+	{
+		return count == 0;
+	}
+
+	std::size_t size() const noexcept
+	{
+		return count;
+	}
+
+	/// Bytes of chunk storage occupied by queued events, excluding memory events own outside the queue.
+	std::size_t byteSize() const noexcept
+	{
+		return usedBytes;
+	}
+
+	/// Bytes allocated by the queue, including chunks kept for reuse.
+	std::size_t memoryUsage() const noexcept
+	{
+		std::size_t bytes = spare.capacity() * sizeof(std::unique_ptr<Chunk>);
+		for (const std::unique_ptr<Chunk>& chunk : chunks)
+			bytes += sizeof(Chunk) + chunk->capacity + sizeof(std::unique_ptr<Chunk>);
+		for (const std::unique_ptr<Chunk>& chunk : spare)
+			bytes += sizeof(Chunk) + chunk->capacity;
+		return bytes;
+	}
+
+	/// Free the chunks kept for reuse, and all chunks if the queue is empty.
+	void trim() noexcept
+	{
+		std::vector<std::unique_ptr<Chunk>>().swap(spare);
+		if (count == 0)
+			chunks.clear();
+	}
+
+private:
+	/// Type-specific operations on a stored payload.
+	struct Ops
+	{
+		void* (*object)(void* payload) noexcept;
+		void (*destroy)(void* payload) noexcept;
+		/// Deadline of the payload, null for payloads without one.
+		EventDeadline (*deadline)(void* payload) noexcept;
+	};
+
+	/// Header preceding each payload in a chunk.
+	struct Record
+	{
+		EventTypeKey key;
+		const Ops* ops;
+		std::uint32_t payload;
+		std::uint32_t end;
+	};
+
+	struct Chunk
+	{
+		explicit Chunk(std::size_t capacity)
+			: capacity(capacity),
+			bytes(std::make_unique_for_overwrite<std::max_align_t[]>((capacity + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t)))
+		{
+		}
+
+		std::byte* data() noexcept
+		{
+			return reinterpret_cast<std::byte*>(bytes.get());
+		}
+
+		Record& record(std::size_t offset) noexcept
+		{
+			return *std::launder(reinterpret_cast<Record*>(data() + offset));
+		}
+
+		std::size_t capacity;
+		std::size_t head = 0;
+		std::size_t tail = 0;
+		std::unique_ptr<std::max_align_t[]> bytes;
+	};
+
+	template <typename T>
+	static void copyBytes(void* payload, const T& event) noexcept
+	{
+		std::memcpy(payload, &event, sizeof(T));
+	}
+
+	static void* self(void* payload) noexcept
+	{
+		return payload;
+	}
+
+	template <typename T>
+	static void destroyValue(void* payload) noexcept
+	{
+		std::launder(static_cast<T*>(payload))->~T();
+	}
+
+	template <typename T>
+	static void* unbox(void* payload) noexcept
+	{
+		return *std::launder(static_cast<T**>(payload));
+	}
+
+	template <typename T>
+	static void destroyBoxed(void* payload) noexcept
+	{
+		delete *std::launder(static_cast<T**>(payload));
+	}
+
+	/// Payload of events stored as unique pointers.
+	template <typename T>
+	struct Owned
+	{
+		std::unique_ptr<T> event;
+		void* object;
+	};
+
+	template <typename T>
+	static void* ownedObject(void* payload) noexcept
+	{
+		return std::launder(static_cast<Owned<T>*>(payload))->object;
+	}
+
+	/// Payload of events queued with a deadline, T is a pointer for boxed events.
+	template <typename T>
+	struct Timed
+	{
+		EventDeadline deadline;
+		T event;
+	};
+
+	template <typename T>
+	static void* timedObject(void* payload) noexcept
+	{
+		return &std::launder(static_cast<Timed<T>*>(payload))->event;
+	}
+
+	template <typename T>
+	static void* timedBoxedObject(void* payload) noexcept
+	{
+		return std::launder(static_cast<Timed<T*>*>(payload))->event;
+	}
+
+	template <typename T>
+	static void destroyTimedBoxed(void* payload) noexcept
+	{
+		delete std::launder(static_cast<Timed<T*>*>(payload))->event;
+	}
+
+	template <typename T>
+	static EventDeadline timedDeadline(void* payload) noexcept
+	{
+		return std::launder(static_cast<Timed<T>*>(payload))->deadline;
+	}
+
+	template <typename T>
+	static constexpr Ops valueOps{ &self, std::is_trivially_destructible_v<T> ? nullptr : &destroyValue<T>, nullptr };
+
+	template <typename T>
+	static constexpr Ops boxedOps{ &unbox<T>, &destroyBoxed<T>, nullptr };
+
+	template <typename T>
+	static constexpr Ops ownedOps{ &ownedObject<T>, &destroyValue<Owned<T>>, nullptr };
+
+	template <typename T>
+	static constexpr Ops timedOps{ &timedObject<T>,
+		std::is_trivially_destructible_v<T> ? nullptr : &destroyValue<Timed<T>>, &timedDeadline<T> };
+
+	template <typename T>
+	static constexpr Ops timedBoxedOps{ &timedBoxedObject<T>, &destroyTimedBoxed<T>, &timedDeadline<T*> };
+
+	/// Operations of a cancelled record, whose payload is already destroyed.
+	static constexpr Ops tombstoneOps{ &self, nullptr, nullptr };
+
+	bool tombstone(Record& record, Chunk& chunk) noexcept
+	{
+		if (record.ops == &tombstoneOps)
+			return false;
+
+		if (record.ops->destroy)
+			record.ops->destroy(chunk.data() + record.payload);
+		record.ops = &tombstoneOps;
+		--count;
+		return true;
+	}
+
+	static constexpr std::size_t alignUp(std::size_t offset, std::size_t alignment) noexcept
+	{
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	/*
+	 * Reserve space for a record at the back of the queue.
+	 *
+	 * @return Pointer to the uninitialized payload.
+	 */
+	void* allocate(EventTypeKey key, const Ops& ops, std::size_t size, std::size_t alignment)
+	{
+		Chunk* chunk = chunks.empty() ? nullptr : chunks.back().get();
+
+		std::size_t start = 0;
+		std::size_t payload = 0;
+		if (chunk)
+		{
+			start = alignUp(chunk->tail, alignof(Record));
+			payload = alignUp(start + sizeof(Record), alignment);
+		}
+		if (!chunk || payload + size > chunk->capacity)
+		{
+			chunk = &addChunk(sizeof(Record) + alignment + size);
+			start = 0;
+			payload = alignUp(sizeof(Record), alignment);
+		}
+
+		std::size_t end = alignUp(payload + size, alignof(Record));
+		new (chunk->data() + start) Record{ key, &ops, static_cast<std::uint32_t>(payload), static_cast<std::uint32_t>(end) };
+		usedBytes += end - start;
+		chunk->tail = end;
+		lastRecord = start;
+		++count;
+		++pushed;
+		return chunk->data() + payload;
+	}
+
+	Chunk& addChunk(std::size_t required)
+	{
+		if (required <= chunkSize && !spare.empty())
+		{
+			chunks.push_back(std::move(spare.back()));
+			spare.pop_back();
+		}
+		else
+		{
+			chunks.push_back(std::make_unique<Chunk>(std::max(chunkSize, required)));
+		}
+		return *chunks.back();
+	}
+
+	void recycleFront()
+	{
+		std::unique_ptr<Chunk> chunk = std::move(chunks.front());
+		chunks.pop_front();
+		if (chunk->capacity == chunkSize)
+		{
+			chunk->head = chunk->tail = 0;
+			spare.push_back(std::move(chunk));
+		}
+	}
+
+	std::deque<std::unique_ptr<Chunk>> chunks;
+	std::vector<std::unique_ptr<Chunk>> spare;
+	/// Number of events, excluding cancelled ones.
+	std::size_t count = 0;
+	std::size_t usedBytes = 0;
+	/// Records ever pushed and consumed, the records in between are queued.
+	std::uint64_t pushed = 0;
+	std::uint64_t popped = 0;
+	/// Offset of the most recently pushed record in the back chunk.
+	std::size_t lastRecord = 0;
+};
@@ -0,0 +1,281 @@
+#pragma once
+#include "EventListener.hpp"
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <bit>
+#include <limits>
+#include <thread>
+#include <initializer_list>
+
+/// How many threads may publish into an EventRingBuffer concurrently.
+enum class ProducerType
+{
+	Single,
+	Multi
+};
+
+/*
+ * Monotonic sequence counter padded to its own cache line.
+ *
+ * Sequences track claimed, published and consumed positions in an EventRingBuffer.
+ */
+struct alignas(64) EventSequence
+{
+	static constexpr std::int64_t initial = -1;
+
+	std::atomic<std::int64_t> value{ initial };
+
+	std::int64_t load() const noexcept
+	{
+		return value.load(std::memory_order_acquire);
+	}
+
+	void store(std::int64_t sequence) noexcept
+	{
+		value.store(sequence, std::memory_order_release);
+	}
+};
+
+/*
+ * Preallocated broadcast ring buffer for a single event type, modeled after the LMAX Disruptor.
+ *
+ * Producers claim sequences and publish events into fixed slots. Every consumer sees every event at
+ * its own pace, and consumers can depend on others so they only see sequence N once their
+ * dependencies have processed it. Publishing and consuming are lock-free and allocation-free.
+ *
+ * @tparam EType The event type carried by the ring.
+ * @tparam Capacity The number of slots, must be a power of two.
+ * @tparam Producer Whether one or several threads publish into the ring.
+ *
+ * @remarks Consumers must be added before the first event is published.
+ *          Each consumer must only be polled by one thread at a time.
+ */
+template <EventType EType, std::size_t Capacity, ProducerType Producer = ProducerType::Single>
+	requires (std::has_single_bit(Capacity) && std::is_default_constructible_v<EType>)
+class EventRingBuffer
+{
+public:
+
+	/*
+	 * A listener reading from the ring at its own pace.
+	 */
+	class Consumer
+	{
+	public:
+
+		/*
+		 * Deliver all events this consumer may currently see to its listener.
+		 *
+		 * @return The number of events delivered.
+		 */
+		std::size_t poll() noexcept
+		{
+			return ring->process(*this);
+		}
+
+		/// The last sequence this consumer has processed.
+		std::int64_t sequence() const noexcept
+		{
+			return processed.load();
+		}
+
+	private:
+		friend class EventRingBuffer;
+
+		EventRingBuffer* ring = nullptr;
+		std::weak_ptr<EventListener<EType>> listener;
+		std::vector<const EventSequence*> dependencies;
+		EventSequence processed;
+	};
+
+	EventRingBuffer()
+		: slots(std::make_unique<EType[]>(Capacity))
+	{
+		if constexpr (Producer == ProducerType::Multi)
+		{
+			published = std::make_unique<std::atomic<std::int64_t>[]>(Capacity);
+			for (std::size_t i = 0; i < Capacity; ++i)
+				published[i].store(EventSequence::initial, std::memory_order_relaxed);
+		}
+	}
+
+	EventRingBuffer(const EventRingBuffer&) = delete;
+	EventRingBuffer& operator=(const EventRingBuffer&) = delete;
+
+	/*
+	 * Add a consumer notifying a listener of every published event.
+	 *
+	 * @param listener A shared pointer to the listener.
+	 * @param dependencies Consumers that must have processed a sequence before this consumer sees it.
+	 * @return The new consumer, owned by the ring.
+	 *
+	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
+	 *          Events are skipped, but still consumed, while the listener is expired.
+	 */
+	Consumer& addConsumer(const std::shared_ptr<EventListener<EType>>& listener,
+		std::initializer_list<const Consumer*> dependencies = {})
+	{
+		auto& consumer = *consumers.emplace_back(std::make_unique<Consumer>());
+		consumer.ring = this;
+		consumer.listener = listener;
+		consumer.processed.store(claimed.load());
+
+		for (const Consumer* dependency : dependencies)
+		{
+			consumer.dependencies.push_back(&dependency->processed);
+			std::erase(gating, &dependency->processed);
+		}
+		gating.push_back(&consumer.processed);
+
+		return consumer;
+	}
+
+	/*
+	 * Claim the next slot, let a callback fill it in place and publish it.
+	 *
+	 * @param fill Callable invoked with a mutable reference to the claimed slot.
+	 * @return False if the ring is full, in which case nothing is published.
+	 */
+	template <typename F>
+	bool tryPublishWith(F&& fill)
+	{
+		std::int64_t sequence;
+		if (!tryClaim(sequence))
+			return false;
+
+		fill(slots[index(sequence)]);
+		commit(sequence);
+		return true;
+	}
+
+	/*
+	 * Publish an event if a slot is free.
+	 *
+	 * @param event The event to copy into the ring.
+	 * @return False if the ring is full.
+	 */
+	bool tryPublish(const EType& event)
+	{
+		return tryPublishWith([&event](EType& slot) { slot = event; });
+	}
+
+	/*
+	 * Publish an event, yielding while the slowest consumer still occupies the next slot.
+	 *
+	 * @param event The event to copy into the ring.
+	 */
+	void publish(const EType& event)
+	{
+		while (!tryPublish(event))
+			std::this_thread::yield();
+	}
+
+	/// The highest sequence claimed by a producer so far.
+	std::int64_t cursor() const noexcept
+	{
+		return claimed.load();
+	}
+
+	static constexpr std::size_t capacity() noexcept
+	{
+		return Capacity;
+	}
+
+private:
+	static constexpr std::int64_t size = static_cast<std::int64_t>(Capacity);
+	static constexpr int shift = std::countr_zero(Capacity);
+
+	static constexpr std::size_t index(std::int64_t sequence) noexcept
+	{
+		return static_cast<std::size_t>(sequence) & (Capacity - 1);
+	}
+
+	std::int64_t minimumGatingSequence(std::int64_t minimum) const noexcept
+	{
+		for (const EventSequence* sequence : gating)
+			minimum = std::min(minimum, sequence->load());
+		return minimum;
+	}
+
+	bool tryClaim(std::int64_t& sequence) noexcept
+	{
+		if constexpr (Producer == ProducerType::Single)
+		{
+			std::int64_t next = claimed.value.load(std::memory_order_relaxed) + 1;
+			if (next - size > gatingCache)
+			{
+				gatingCache = minimumGatingSequence(next - 1);
+				if (next - size > gatingCache)
+					return false;
+			}
+			claimed.value.store(next, std::memory_order_relaxed);
+			sequence = next;
+			return true;
+		}
+		else
+		{
+			std::int64_t current = claimed.value.load(std::memory_order_relaxed);
+			do
+			{
+				std::int64_t next = current + 1;
+				if (next - size > minimumGatingSequence(current))
+					return false;
+				sequence = next;
+			} while (!claimed.value.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel));
+			return true;
+		}
+	}
+
+	void commit(std::int64_t sequence) noexcept
+	{
+		if constexpr (Producer == ProducerType::Single)
+			cursorSequence.store(sequence);
+		else
+			published[index(sequence)].store(sequence >> shift, std::memory_order_release);
+	}
+
+	std::int64_t highestPublished(std::int64_t next) const noexcept
+	{
+		if constexpr (Producer == ProducerType::Single)
+		{
+			return cursorSequence.load();
+		}
+		else
+		{
+			std::int64_t last = claimed.load();
+			for (std::int64_t sequence = next; sequence <= last; ++sequence)
+				if (published[index(sequence)].load(std::memory_order_acquire) != (sequence >> shift))
+					return sequence - 1;
+			return last;
+		}
+	}
+
+	std::size_t process(Consumer& consumer) noexcept
+	{
+		std::int64_t next = consumer.processed.value.load(std::memory_order_relaxed) + 1;
+
+		std::int64_t available = highestPublished(next);
+		for (const EventSequence* dependency : consumer.dependencies)
+			available = std::min(available, dependency->load());
+
+		if (available < next)
+			return 0;
+
+		if (auto l = consumer.listener.lock())
+			for (std::int64_t sequence = next; sequence <= available; ++sequence)
+				l->onEvent(slots[index(sequence)]);
+
+		consumer.processed.store(available);
+		return static_cast<std::size_t>(available - next + 1);
+	}
+
+	std::unique_ptr<EType[]> slots;
+	std::unique_ptr<std::atomic<std::int64_t>[]> published;
+	EventSequence claimed;
+	EventSequence cursorSequence;
+	std::int64_t gatingCache = EventSequence::initial;
+	std::vector<const EventSequence*> gating;
+	std::vector<std::unique_ptr<Consumer>> consumers;
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include "Event.hpp"
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/// Identifier of an event type that stays the same across builds and processes.
+using EventTypeId = std::uint64_t;
+
+/// 64 bit FNV-1a hash of a string.
+constexpr std::uint64_t fnv1a(std::string_view text, std::uint64_t hash = 14695981039346656037ull) noexcept
+{
+	for (char c : text)
+	{
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/// 64 bit FNV-1a hash of a byte range.
+inline std::uint64_t fnv1a(std::span<const std::byte> bytes, std::uint64_t hash = 14695981039346656037ull) noexcept
+{
+	for (std::byte b : bytes)
+	{
+		hash ^= static_cast<unsigned char>(b);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+/*
+ * Get the stable identifier of an event type.
+ *
+ * Unlike type keys, which are addresses, identifiers are derived from the type's name and can be written to
+ * disk or sent to other processes.
+ *
+ * @tparam T The event type.
+ */
+template<class T>
+constexpr EventTypeId eventTypeId() noexcept
+{
+	return fnv1a(eventTypeName<T>());
+}
+
+/*
+ * Converts events of a type to and from bytes.
+ *
+ * Trivially copyable events are serialized as their object representation. Specialize this template for other
+ * event types, providing:
+ *   static void encode(const T& event, std::vector<std::byte>& out), appending the event's bytes to out.
+ *   static std::optional<T> decode(std::span<const std::byte> bytes), returning nullopt for malformed input.
+ *
+ * @tparam T The event type.
+ */
+template <typename T>
+struct EventCodec
+{
+};
+
+template <typename T>
+	requires std::is_trivially_copyable_v<T>
+struct EventCodec<T>
+{
+	static void encode(const T& event, std::vector<std::byte>& out)
+	{
+		const std::byte* bytes = reinterpret_cast<const std::byte*>(&event);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	static std::optional<T> decode(std::span<const std::byte> bytes) noexcept
+	{
+		if (bytes.size() != sizeof(T))
+			return std::nullopt;
+
+		std::array<std::byte, sizeof(T)> copy;
+		std::memcpy(copy.data(), bytes.data(), sizeof(T));
+		return std::bit_cast<T>(copy);
+	}
+};
+
+/// Concept for event types that have an EventCodec.
+template <class T>
+concept SerializableEvent = EventType<T> && requires(const T& event, std::vector<std::byte>& out, std::span<const std::byte> bytes)
+{
+	EventCodec<T>::encode(event, out);
+	{ EventCodec<T>::decode(bytes) } -> std::same_as<std::optional<T>>;
+};
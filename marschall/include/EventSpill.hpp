@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <span>
+
+/*
+ * Interface for storage that queued events overflow into once the queue exceeds its memory budget.
+ *
+ * A spill is a FIFO of opaque records. The dispatcher writes serialized events to it and reads them back in
+ * the same order while processing its queue.
+ */
+class IEventSpill
+{
+public:
+	virtual ~IEventSpill() = default;
+
+	/*
+	 * Append a record.
+	 *
+	 * @param record The bytes of the record.
+	 * @return False if the record could not be stored.
+	 */
+	virtual bool write(std::span<const std::byte> record) = 0;
+
+	/*
+	 * Remove the oldest record.
+	 *
+	 * @return The bytes of the record, empty if there is none. Valid until the next call to read or write.
+	 */
+	virtual std::span<const std::byte> read() = 0;
+
+	/// Number of records written and not read yet.
+	virtual std::size_t size() const noexcept = 0;
+};
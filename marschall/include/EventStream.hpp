@@ -0,0 +1,246 @@
+#pragma once
+#include "Event.hpp"
+#include <memory>
+#include <vector>
+#include <span>
+#include <limits>
+#include <algorithm>
+
+/*
+ * Type-erased interface for event streams.
+ *
+ * Lets the dispatcher append events to a stream when the static event type is only known at runtime.
+ */
+class IEventStream
+{
+public:
+	virtual ~IEventStream() = default;
+	virtual void append(const void* event) = 0;
+	virtual bool hasReaders() const noexcept = 0;
+	/// Bytes allocated by the stream.
+	virtual std::size_t memoryUsage() const noexcept = 0;
+	/// Release storage of events every reader has consumed.
+	virtual void shrink() = 0;
+};
+
+template <EventType EType>
+class EventReader;
+
+/*
+ * Contiguous, pull-based column of events of a single type.
+ *
+ * Events are appended by value and read in bulk by any number of readers, each with its own cursor.
+ * Storage is reclaimed once every reader has advanced past it.
+ *
+ * @tparam EType The event type stored in this stream.
+ *
+ * @remarks Streams must be owned by a shared pointer, readers keep their stream alive.
+ */
+template <EventType EType>
+class EventStream : public IEventStream, public std::enable_shared_from_this<EventStream<EType>>
+{
+public:
+
+	/*
+	 * Append an event to the stream.
+	 *
+	 * @param event The event to append.
+	 *
+	 * @remarks Events appended while no reader exists are discarded.
+	 *          Appending may invalidate spans previously returned by readers.
+	 */
+	void append(const EType& event)
+	{
+		if (liveReaders == 0)
+			return;
+
+		if (events.size() == events.capacity())
+			reclaim();
+
+		events.push_back(event);
+	}
+
+	void append(const void* event) override
+	{
+		append(*static_cast<const EType*>(event));
+	}
+
+	/*
+	 * Create a new reader for this stream.
+	 *
+	 * The reader only sees events appended after its creation.
+	 *
+	 * @return The new reader.
+	 */
+	EventReader<EType> createReader()
+	{
+		auto slot = std::find(cursors.begin(), cursors.end(), freeSlot);
+		if (slot == cursors.end())
+			slot = cursors.insert(cursors.end(), freeSlot);
+
+		*slot = end();
+		++liveReaders;
+
+		return EventReader<EType>(this->shared_from_this(), static_cast<std::size_t>(slot - cursors.begin()));
+	}
+
+	bool hasReaders() const noexcept override
+	{
+		return liveReaders != 0;
+	}
+
+	/// Number of events currently held by the stream.
+	std::size_t size() const noexcept
+	{
+		return events.size();
+	}
+
+	std::size_t memoryUsage() const noexcept override
+	{
+		return events.capacity() * sizeof(EType) + cursors.capacity() * sizeof(std::size_t);
+	}
+
+	/*
+	 * Release storage of events every reader has consumed.
+	 *
+	 * @remarks Invalidates spans previously returned by readers.
+	 */
+	void shrink() override
+	{
+		reclaim();
+		events.shrink_to_fit();
+		while (!cursors.empty() && cursors.back() == freeSlot)
+			cursors.pop_back();
+		cursors.shrink_to_fit();
+	}
+
+private:
+	friend class EventReader<EType>;
+
+	static constexpr std::size_t freeSlot = std::numeric_limits<std::size_t>::max();
+
+	std::size_t end() const noexcept
+	{
+		return base + events.size();
+	}
+
+	std::span<const EType> read(std::size_t reader) noexcept
+	{
+		std::size_t first = cursors[reader] - base;
+		cursors[reader] = end();
+		return std::span<const EType>(events).subspan(first);
+	}
+
+	std::size_t pending(std::size_t reader) const noexcept
+	{
+		return end() - cursors[reader];
+	}
+
+	void release(std::size_t reader) noexcept
+	{
+		cursors[reader] = freeSlot;
+		if (--liveReaders == 0)
+		{
+			base = end();
+			events.clear();
+		}
+	}
+
+	/*
+	 * Drop the prefix of events every reader has already consumed.
+	 *
+	 * Only called when the column is about to grow, which keeps the cost amortized over appends.
+	 */
+	void reclaim()
+	{
+		std::size_t consumed = end();
+		for (std::size_t cursor : cursors)
+			if (cursor != freeSlot)
+				consumed = std::min(consumed, cursor);
+
+		if (consumed == base)
+			return;
+
+		events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(consumed - base));
+		base = consumed;
+	}
+
+	std::vector<EType> events;
+	std::size_t base = 0;
+	std::vector<std::size_t> cursors;
+	std::size_t liveReaders = 0;
+};
+
+/*
+ * Reader with an independent cursor into an EventStream.
+ *
+ * Each call to read returns all events appended since the previous call as one contiguous span.
+ *
+ * @tparam EType The event type read by this reader.
+ */
+template <EventType EType>
+class EventReader
+{
+public:
+	EventReader(EventReader&& other) noexcept
+		: stream(std::move(other.stream)), slot(other.slot)
+	{
+	}
+
+	EventReader& operator=(EventReader&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+			stream = std::move(other.stream);
+			slot = other.slot;
+		}
+		return *this;
+	}
+
+	EventReader(const EventReader&) = delete;
+	EventReader& operator=(const EventReader&) = delete;
+
+	~EventReader()
+	{
+		reset();
+	}
+
+	/*
+	 * Read all unread events and advance the cursor past them.
+	 *
+	 * @return A span over the unread events.
+	 *
+	 * @remarks The span stays valid until the next event is appended to the stream.
+	 */
+	std::span<const EType> read() noexcept
+	{
+		return stream ? stream->read(slot) : std::span<const EType>{};
+	}
+
+	/// Number of events appended since the last read.
+	std::size_t pending() const noexcept
+	{
+		return stream ? stream->pending(slot) : 0;
+	}
+
+private:
+	friend class EventStream<EType>;
+
+	EventReader(std::shared_ptr<EventStream<EType>> stream, std::size_t slot)
+		: stream(std::move(stream)), slot(slot)
+	{
+	}
+
+	void reset() noexcept
+	{
+		if (stream)
+		{
+			stream->release(slot);
+			stream.reset();
+		}
+	}
+
+	std::shared_ptr<EventStream<EType>> stream;
+	std::size_t slot = 0;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include "Event.hpp"
+#include "EventQueue.hpp"
+#include <type_traits>
+#include <utility>
+
+/// Anything events can be committed to in one step, such as an EventDispatcher or an EventLoop.
+template <typename T>
+concept EventQueueTarget = requires(T& target, EventQueue& events)
+{
+	target.queueEvents(events);
+};
+
+/*
+ * Group of events queued together, so that they are processed all or none and back to back.
+ *
+ * Events are staged in the transaction's own queue without touching the target. Committing hands the whole
+ * queue over in a single step, no other event is queued in between and processQueue delivers the group
+ * contiguously. A transaction destroyed or cleared before committing discards its events.
+ *
+ * Committing to an EventLoop takes its lock once for the whole group, which makes the group visible to the
+ * loop's thread atomically without a lock of your own around it.
+ */
+class EventTransaction
+{
+public:
+	EventTransaction() = default;
+	EventTransaction(const EventTransaction&) = delete;
+	EventTransaction& operator=(const EventTransaction&) = delete;
+
+	/*
+	 * Stage an event by value.
+	 *
+	 * @tparam EType The event type to stage.
+	 * @param event The event to stage.
+	 */
+	template <typename E, EventType EType = std::remove_cvref_t<E>>
+	void queueEvent(E&& event)
+	{
+		events.emplace<EType>(eventTypeKey<EType>(), std::forward<E>(event));
+	}
+
+	/*
+	 * Construct an event directly in the transaction's storage.
+	 *
+	 * @tparam EType The event type to stage.
+	 * @param args The arguments to construct the event from.
+	 */
+	template <EventType EType, typename... Args>
+	void queueEmplace(Args&&... args)
+	{
+		events.emplace<EType>(eventTypeKey<EType>(), std::forward<Args>(args)...);
+	}
+
+	/*
+	 * Queue all staged events at the target in one step, leaving the transaction empty for reuse.
+	 *
+	 * @param target The dispatcher or event loop to queue the events at.
+	 */
+	template <EventQueueTarget Target>
+	void commit(Target& target)
+	{
+		target.queueEvents(events);
+	}
+
+	/// Discard all staged events.
+	void clear() noexcept
+	{
+		events.clear();
+	}
+
+	bool empty() const noexcept
+	{
+		return events.empty();
+	}
+
+	std::size_t size() const noexcept
+	{
+		return events.size();
+	}
+
+private:
+	EventQueue events;
+};
@@ -0,0 +1,262 @@
+#pragma once
+#include "EventListener.hpp"
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Fixed-capacity event dispatcher for real-time threads.
+ *
+ * All storage is held inline, so dispatch, queueEvent and processQueue never allocate and never lock.
+ * Operations return false instead of growing when a capacity is exceeded.
+ *
+ * @tparam MaxTypes The maximum number of event types with subscribers.
+ * @tparam MaxSubscribers The maximum number of subscribers per event type.
+ * @tparam MaxQueueDepth The maximum number of queued events.
+ * @tparam MaxEventSize The maximum size in bytes of a queued event.
+ *
+ * @remarks Subscribing and dispatching must happen on one thread. The queue is a single-producer,
+ *          single-consumer ring, so one other thread may queue events while the owning thread processes them.
+ */
+template <std::size_t MaxTypes, std::size_t MaxSubscribers, std::size_t MaxQueueDepth, std::size_t MaxEventSize = 64>
+class FixedEventDispatcher
+{
+public:
+	FixedEventDispatcher() = default;
+	FixedEventDispatcher(const FixedEventDispatcher&) = delete;
+	FixedEventDispatcher& operator=(const FixedEventDispatcher&) = delete;
+
+	~FixedEventDispatcher()
+	{
+		clearQueue();
+	}
+
+	/*
+	 * Subscribe a listener to a specific event type.
+	 *
+	 * @tparam EType The event type to subscribe to.
+	 * @param listener A shared pointer to the listener.
+	 * @return False if the maximum number of types or subscribers was reached.
+	 *
+	 * @remarks The listener is stored as a weak pointer to avoid dangling references.
+	 */
+	template <EventType EType>
+	bool subscribeTo(const std::shared_ptr<EventListener<EType>>& listener)
+	{
+		TypeSlot* slot = findSlot(eventTypeKey<EType>(), true);
+		if (!slot)
+			return false;
+
+		const IEventListener* id = listener.get();
+		for (std::size_t i = 0; i < slot->count; ++i)
+			if (slot->subscribers[i].id == id)
+				return true;
+
+		if (slot->count == MaxSubscribers)
+			return false;
+
+		slot->subscribers[slot->count++] = Subscriber{ id, listener, &invoke<EType> };
+		return true;
+	}
+
+	/*
+	 * Unsubscribe a listener from a specific event type.
+	 *
+	 * @tparam EType The event type to unsubscribe from.
+	 * @param listener A shared pointer to the listener.
+	 */
+	template <EventType EType>
+	void unsubscribeFrom(const std::shared_ptr<EventListener<EType>>& listener)
+	{
+		TypeSlot* slot = findSlot(eventTypeKey<EType>(), false);
+		if (!slot)
+			return;
+
+		const IEventListener* id = listener.get();
+		for (std::size_t i = 0; i < slot->count; ++i)
+			if (slot->subscribers[i].id == id)
+				slot->subscribers[i].listener.reset();
+
+		compact(*slot);
+	}
+
+	/*
+	 * Dispatch an event to all subscribed listeners.
+	 *
+	 * This blocks until all listeners have been notified. Expired listeners are removed.
+	 *
+	 * @tparam EType The event type to dispatch.
+	 * @param event The event to dispatch.
+	 */
+	template <EventType EType>
+	void dispatch(const EType& event) noexcept
+	{
+		notify(eventTypeKey<EType>(), &event);
+	}
+
+	/*
+	 * Copy an event into the queue for later processing.
+	 *
+	 * @tparam EType The event type to queue.
+	 * @param event The event to queue.
+	 * @return False if the queue is full.
+	 */
+	template <EventType EType>
+		requires (sizeof(EType) <= MaxEventSize && alignof(EType) <= alignof(std::max_align_t))
+	bool queueEvent(const EType& event) noexcept(std::is_nothrow_copy_constructible_v<EType>)
+	{
+		std::size_t tail = queueTail.load(std::memory_order_relaxed);
+		if (tail - queueHead.load(std::memory_order_acquire) == MaxQueueDepth)
+			return false;
+
+		QueueSlot& slot = queue[tail % MaxQueueDepth];
+		new (slot.storage) EType(event);
+		slot.key = eventTypeKey<EType>();
+		slot.destroy = std::is_trivially_destructible_v<EType> ? nullptr : &destroy<EType>;
+
+		queueTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+	 * Process all queued events, dispatching them to their subscribed listeners.
+	 *
+	 * Events queued while processing are processed in the same call.
+	 */
+	void processQueue() noexcept
+	{
+		std::size_t head = queueHead.load(std::memory_order_relaxed);
+		while (head != queueTail.load(std::memory_order_acquire))
+		{
+			QueueSlot& slot = queue[head % MaxQueueDepth];
+			notify(slot.key, slot.storage);
+			if (slot.destroy)
+				slot.destroy(slot.storage);
+
+			queueHead.store(++head, std::memory_order_release);
+		}
+	}
+
+	/// The number of events waiting in the queue.
+	std::size_t queueSize() const noexcept
+	{
+		return queueTail.load(std::memory_order_acquire) - queueHead.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Subscriber
+	{
+		const IEventListener* id = nullptr;
+		std::weak_ptr<IEventListener> listener;
+		void (*invoke)(IEventListener&, const void*) = nullptr;
+	};
+
+	struct TypeSlot
+	{
+		EventTypeKey key = nullptr;
+		std::size_t count = 0;
+		std::array<Subscriber, MaxSubscribers> subscribers;
+	};
+
+	struct QueueSlot
+	{
+		EventTypeKey key = nullptr;
+		void (*destroy)(void*) noexcept = nullptr;
+		alignas(std::max_align_t) std::byte storage[MaxEventSize];
+	};
+
+	template <EventType EType>
+	static void invoke(IEventListener& listener, const void* event)
+	{
+		static_cast<EventListener<EType>&>(listener).onEvent(*static_cast<const EType*>(event));
+	}
+
+	template <EventType EType>
+	static void destroy(void* event) noexcept
+	{
+		std::launder(static_cast<EType*>(event))->~EType();
+	}
+
+	/*
+	 * Find the slot of an event type using open addressing.
+	 *
+	 * @param create Whether to claim a free slot if the type has none yet.
+	 */
+	TypeSlot* findSlot(EventTypeKey key, bool create) noexcept
+	{
+		std::size_t index = (reinterpret_cast<std::uintptr_t>(key) >> 3) % MaxTypes;
+		for (std::size_t probe = 0; probe < MaxTypes; ++probe)
+		{
+			TypeSlot& slot = types[(index + probe) % MaxTypes];
+			if (slot.key == key)
+				return &slot;
+			if (slot.key == nullptr)
+			{
+				if (!create)
+					return nullptr;
+				slot.key = key;
+				return &slot;
+			}
+		}
+		return nullptr;
+	}
+
+	void notify(EventTypeKey key, const void* event) noexcept
+	{
+		TypeSlot* slot = findSlot(key, false);
+		if (!slot)
+			return;
+
+		bool expired = false;
+		for (std::size_t i = 0; i < slot->count; ++i)
+		{
+			Subscriber& subscriber = slot->subscribers[i];
+			if (auto l = subscriber.listener.lock())
+				subscriber.invoke(*l, event);
+			else
+				expired = true;
+		}
+
+		if (expired)
+			compact(*slot);
+	}
+
+	/// Remove subscribers whose listener expired or was reset, preserving the order of the others.
+	static void compact(TypeSlot& slot) noexcept
+	{
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < slot.count; ++i)
+		{
+			if (slot.subscribers[i].listener.expired())
+				continue;
+			if (kept != i)
+				slot.subscribers[kept] = std::move(slot.subscribers[i]);
+			++kept;
+		}
+		for (std::size_t i = kept; i < slot.count; ++i)
+			slot.subscribers[i] = Subscriber{};
+		slot.count = kept;
+	}
+
+	void clearQueue() noexcept
+	{
+		std::size_t head = queueHead.load(std::memory_order_relaxed);
+		for (; head != queueTail.load(std::memory_order_relaxed); ++head)
+		{
+			QueueSlot& slot = queue[head % MaxQueueDepth];
+			if (slot.destroy)
+				slot.destroy(slot.storage);
+		}
+		queueHead.store(head, std::memory_order_relaxed);
+	}
+
+	std::array<TypeSlot, MaxTypes> types{};
+	std::array<QueueSlot, MaxQueueDepth> queue{};
+	alignas(64) std::atomic<std::size_t> queueHead{ 0 };
+	alignas(64) std::atomic<std::size_t> queueTail{ 0 };
+};
@@ -0,0 +1,173 @@
+#pragma once
+#include "EventSpill.hpp"
+#include <deque>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/*
+ * Event spill backed by memory-mapped segment files.
+ *
+ * Records are copied into a mapped segment until it is full, then the segment is unmapped so the kernel can
+ * write its pages back and reclaim them, and a new segment is started. Segments are mapped again for reading
+ * and deleted once read. Segment files are unlinked right after creation, so nothing is left behind on a crash.
+ *
+ * @remarks Requires POSIX mmap.
+ */
+class MappedEventSpill : public IEventSpill
+{
+public:
+
+	/*
+	 * @param directory Directory to create segment files in.
+	 * @param segmentSize Size in bytes of each segment, larger records get a segment of their own.
+	 */
+	explicit MappedEventSpill(std::string directory, std::size_t segmentSize = std::size_t{ 16 } << 20)
+		: directory(std::move(directory)), segmentSize(segmentSize)
+	{
+	}
+
+	MappedEventSpill(const MappedEventSpill&) = delete;
+	MappedEventSpill& operator=(const MappedEventSpill&) = delete;
+
+	~MappedEventSpill() override
+	{
+		for (Segment& segment : segments)
+			release(segment);
+	}
+
+	bool write(std::span<const std::byte> record) override
+	{
+		std::size_t required = sizeof(std::uint64_t) + alignUp(record.size());
+
+		if (segments.empty() || segments.back().end + required > segments.back().capacity)
+		{
+			if (segments.size() > 1)
+				unmap(segments.back());
+
+			Segment segment;
+			if (!create(segment, std::max(segmentSize, required)))
+				return false;
+			segments.push_back(segment);
+		}
+
+		Segment& segment = segments.back();
+		std::uint64_t length = record.size();
+		std::memcpy(segment.data + segment.end, &length, sizeof(length));
+		if (!record.empty())
+			std::memcpy(segment.data + segment.end + sizeof(length), record.data(), record.size());
+		segment.end += required;
+		++count;
+		return true;
+	}
+
+	std::span<const std::byte> read() override
+	{
+		while (!segments.empty())
+		{
+			Segment& segment = segments.front();
+			if (readOffset == segment.end)
+			{
+				if (segments.size() == 1)
+				{
+					readOffset = segment.end = 0;
+					return {};
+				}
+				release(segment);
+				segments.pop_front();
+				readOffset = 0;
+				continue;
+			}
+
+			if (!segment.data && !map(segment))
+				return {};
+
+			std::uint64_t length;
+			std::memcpy(&length, segment.data + readOffset, sizeof(length));
+			const std::byte* record = segment.data + readOffset + sizeof(length);
+			readOffset += sizeof(length) + alignUp(static_cast<std::size_t>(length));
+			--count;
+			return { record, static_cast<std::size_t>(length) };
+		}
+		return {};
+	}
+
+	std::size_t size() const noexcept override
+	{
+		return count;
+	}
+
+	/// Number of segment files currently held.
+	std::size_t segmentCount() const noexcept
+	{
+		return segments.size();
+	}
+
+private:
+	struct Segment
+	{
+		int file = -1;
+		std::byte* data = nullptr;
+		std::size_t capacity = 0;
+		std::size_t end = 0;
+	};
+
+	static constexpr std::size_t alignUp(std::size_t size) noexcept
+	{
+		return (size + alignof(std::uint64_t) - 1) & ~(alignof(std::uint64_t) - 1);
+	}
+
+	bool create(Segment& segment, std::size_t capacity)
+	{
+		std::string path = directory + "/marschall-spill-XXXXXX";
+		int file = ::mkstemp(path.data());
+		if (file == -1)
+			return false;
+		::unlink(path.c_str());
+
+		segment.file = file;
+		segment.capacity = capacity;
+		if (::ftruncate(file, static_cast<off_t>(capacity)) != 0 || !map(segment))
+		{
+			release(segment);
+			return false;
+		}
+		return true;
+	}
+
+	static bool map(Segment& segment) noexcept
+	{
+		void* data = ::mmap(nullptr, segment.capacity, PROT_READ | PROT_WRITE, MAP_SHARED, segment.file, 0);
+		if (data == MAP_FAILED)
+			return false;
+		segment.data = static_cast<std::byte*>(data);
+		return true;
+	}
+
+	static void unmap(Segment& segment) noexcept
+	{
+		if (segment.data)
+			::munmap(segment.data, segment.capacity);
+		segment.data = nullptr;
+	}
+
+	static void release(Segment& segment) noexcept
+	{
+		unmap(segment);
+		if (segment.file != -1)
+			::close(segment.file);
+		segment.file = -1;
+	}
+
+	std::string directory;
+	std::size_t segmentSize;
+	std::deque<Segment> segments;
+	std::size_t readOffset = 0;
+	std::size_t count = 0;
+};
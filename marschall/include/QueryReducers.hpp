@@ -0,0 +1,235 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+#include <concepts>
+
+/*
+ * Vector storing up to N elements inline before falling back to the heap.
+ *
+ * @tparam T The element type.
+ * @tparam N The number of elements stored without allocating.
+ */
+template <typename T, std::size_t N>
+class SmallVector
+{
+public:
+	SmallVector() = default;
+
+	SmallVector(const SmallVector& other)
+	{
+		for (const T& value : other)
+			push_back(value);
+	}
+
+	SmallVector(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		take(std::move(other));
+	}
+
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			for (const T& value : other)
+				push_back(value);
+		}
+		return *this;
+	}
+
+	SmallVector& operator=(SmallVector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+	{
+		if (this != &other)
+		{
+			clear();
+			heap.reset();
+			capacity = N;
+			take(std::move(other));
+		}
+		return *this;
+	}
+
+	~SmallVector()
+	{
+		clear();
+	}
+
+	void push_back(T value)
+	{
+		if (count == capacity)
+			grow();
+		new (data() + count) T(std::move(value));
+		++count;
+	}
+
+	void clear() noexcept
+	{
+		std::destroy_n(data(), count);
+		count = 0;
+	}
+
+	T* data() noexcept
+	{
+		return heap ? std::launder(reinterpret_cast<T*>(heap.get())) : std::launder(reinterpret_cast<T*>(buffer));
+	}
+
+	const T* data() const noexcept
+	{
+		return heap ? std::launder(reinterpret_cast<const T*>(heap.get())) : std::launder(reinterpret_cast<const T*>(buffer));
+	}
+
+	std::size_t size() const noexcept { return count; }
+	bool empty() const noexcept { return count == 0; }
+	/// True while all elements are stored inline.
+	bool isInline() const noexcept { return !heap; }
+
+	T& operator[](std::size_t index) noexcept { return data()[index]; }
+	const T& operator[](std::size_t index) const noexcept { return data()[index]; }
+
+	T* begin() noexcept { return data(); }
+	T* end() noexcept { return data() + count; }
+	const T* begin() const noexcept { return data(); }
+	const T* end() const noexcept { return data() + count; }
+
+	operator std::span<const T>() const noexcept { return { data(), count }; }
+
+private:
+	struct alignas(T) Storage
+	{
+		std::byte bytes[sizeof(T)];
+	};
+
+	void take(SmallVector&& other)
+	{
+		if (other.heap)
+		{
+			heap = std::move(other.heap);
+			count = other.count;
+			capacity = other.capacity;
+			other.count = 0;
+			other.capacity = N;
+		}
+		else
+		{
+			for (T& value : other)
+				push_back(std::move(value));
+			other.clear();
+		}
+	}
+
+	void grow()
+	{
+		std::size_t grown = capacity * 2;
+		auto storage = std::make_unique<Storage[]>(grown);
+		T* target = std::launder(reinterpret_cast<T*>(storage.get()));
+		std::uninitialized_move_n(data(), count, target);
+		std::destroy_n(data(), count);
+		heap = std::move(storage);
+		capacity = grown;
+	}
+
+	alignas(T) std::byte buffer[sizeof(T) * N];
+	std::unique_ptr<Storage[]> heap;
+	std::size_t count = 0;
+	std::size_t capacity = N;
+};
+
+/*
+ * Reducers combine the results of listeners answering a request.
+ *
+ * A reducer's add method receives each result and returns false once the reducer is satisfied,
+ * in which case the remaining listeners are skipped. The result method yields the combined value.
+ */
+template <typename Reducer, typename Result>
+concept ResultReducer = requires(Reducer reducer, Result value)
+{
+	{ reducer.add(std::move(value)) } -> std::convertible_to<bool>;
+	reducer.result();
+};
+
+/// Keeps the first result and skips all remaining listeners.
+template <typename T>
+class FirstResult
+{
+public:
+	bool add(T value)
+	{
+		first.emplace(std::move(value));
+		return false;
+	}
+
+	std::optional<T> result() { return std::move(first); }
+
+private:
+	std::optional<T> first;
+};
+
+/// True if any listener answered true, stops at the first true answer.
+class AnyResult
+{
+public:
+	bool add(bool value) noexcept
+	{
+		any = value;
+		return !value;
+	}
+
+	bool result() const noexcept { return any; }
+
+private:
+	bool any = false;
+};
+
+/// True if all listeners answered true, stops at the first false answer.
+class AllResult
+{
+public:
+	bool add(bool value) noexcept
+	{
+		all = value;
+		return value;
+	}
+
+	bool result() const noexcept { return all; }
+
+private:
+	bool all = true;
+};
+
+/// Sums the results of all listeners.
+template <typename T>
+class SumResult
+{
+public:
+	bool add(T value)
+	{
+		sum += std::move(value);
+		return true;
+	}
+
+	T result() { return std::move(sum); }
+
+private:
+	T sum{};
+};
+
+/// Collects the results of all listeners, without allocating for up to N results.
+template <typename T, std::size_t N = 8>
+class CollectResults
+{
+public:
+	bool add(T value)
+	{
+		results.push_back(std::move(value));
+		return true;
+	}
+
+	SmallVector<T, N> result() { return std::move(results); }
+
+private:
+	SmallVector<T, N> results;
+};
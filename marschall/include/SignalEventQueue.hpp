@@ -0,0 +1,167 @@
+#pragma once
+#include "Event.hpp"
+#include <atomic>
+#include <memory>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*
+ * Fixed-capacity, lock-free queue of trivially copyable events that may be filled from signal handlers.
+ *
+ * Pushing neither locks nor allocates nor waits for other threads, so it is async-signal-safe and can be used
+ * from any low-level callback. Any number of threads and signal handlers may push concurrently.
+ * Attach the queue to an EventDispatcher to have processQueue deliver its events.
+ *
+ * @remarks This is a bounded multi-producer queue with a sequence number per slot. A push interrupted by a
+ *          signal handler pushing to the same queue is not waited for, the handler claims another slot.
+ */
+class SignalEventQueue
+{
+public:
+	/// Maximum size in bytes of an event.
+	static constexpr std::size_t maxEventSize = 64;
+
+	static_assert(std::atomic<std::size_t>::is_always_lock_free, "signal safety requires lock-free atomics");
+
+	/*
+	 * @param capacity The maximum number of queued events, rounded up to a power of two.
+	 *
+	 * @remarks All memory is allocated here, never while pushing.
+	 */
+	explicit SignalEventQueue(std::size_t capacity)
+		: mask(std::bit_ceil(capacity < 2 ? std::size_t{ 2 } : capacity) - 1),
+		slots(std::make_unique<Slot[]>(mask + 1))
+	{
+		for (std::size_t i = 0; i <= mask; ++i)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	SignalEventQueue(const SignalEventQueue&) = delete;
+	SignalEventQueue& operator=(const SignalEventQueue&) = delete;
+
+	/*
+	 * Copy an event into the queue.
+	 *
+	 * Async-signal-safe.
+	 *
+	 * @tparam EType The event type.
+	 * @param event The event to queue.
+	 * @return False if the queue is full, in which case the event is counted as dropped.
+	 */
+	template <EventType EType>
+		requires (std::is_trivially_copyable_v<EType> && sizeof(EType) <= maxEventSize && alignof(EType) <= alignof(std::max_align_t))
+	bool push(const EType& event) noexcept
+	{
+		std::size_t position = tail.load(std::memory_order_relaxed);
+		Slot* slot;
+		for (;;)
+		{
+			slot = &slots[position & mask];
+			std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+			if (difference == 0)
+			{
+				if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+			{
+				drops.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				position = tail.load(std::memory_order_relaxed);
+			}
+		}
+
+		slot->key = eventTypeKey<EType>();
+		std::memcpy(slot->storage, &event, sizeof(EType));
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+	 * Remove all events that are completely pushed, passing each to a callback.
+	 *
+	 * Each event is copied out of its slot before the callback runs, so the slot is free again while it does.
+	 *
+	 * @param f Callable invoked with the type key and a pointer to a copy of the event.
+	 * @return The number of events removed.
+	 */
+	template <typename F>
+	std::size_t drain(F&& f)
+	{
+		std::size_t drained = 0;
+		EventTypeKey key;
+		alignas(std::max_align_t) std::byte event[maxEventSize];
+		while (pop(key, event))
+		{
+			f(key, static_cast<void*>(event));
+			++drained;
+		}
+		return drained;
+	}
+
+	/// The number of events that could not be queued because the queue was full.
+	std::size_t dropped() const noexcept
+	{
+		return drops.load(std::memory_order_relaxed);
+	}
+
+	std::size_t capacity() const noexcept
+	{
+		return mask + 1;
+	}
+
+	bool empty() const noexcept
+	{
+		std::size_t position = head.load(std::memory_order_relaxed);
+		return slots[position & mask].sequence.load(std::memory_order_acquire) != position + 1;
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<std::size_t> sequence;
+		EventTypeKey key = nullptr;
+		alignas(std::max_align_t) std::byte storage[maxEventSize];
+	};
+
+	bool pop(EventTypeKey& key, std::byte* event) noexcept
+	{
+		std::size_t position = head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots[position & mask];
+			std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+			if (difference == 0)
+			{
+				if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					key = slot.key;
+					std::memcpy(event, slot.storage, maxEventSize);
+					slot.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				position = head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	const std::size_t mask;
+	std::unique_ptr<Slot[]> slots;
+	alignas(64) std::atomic<std::size_t> tail{ 0 };
+	alignas(64) std::atomic<std::size_t> head{ 0 };
+	std::atomic<std::size_t> drops{ 0 };
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include "EventListener.hpp"
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Type-erased view of a StaticSubscriptionTable, handed to an EventDispatcher.
+ */
+struct StaticTopology
+{
+	void (*dispatch)(EventTypeKey key, const void* event);
+	bool (*observes)(EventTypeKey key);
+	std::size_t size;
+};
+
+/*
+ * Declares a subscription of a listener with static storage duration to an event type.
+ *
+ * @tparam Listener The listener object, typically declared constinit at namespace scope.
+ * @tparam EType The event type to subscribe to.
+ * @tparam Priority Listeners with a higher priority are notified first.
+ */
+template <auto& Listener, EventType EType, int Priority = 0>
+struct StaticSubscription
+{
+	using Event = EType;
+	static constexpr int priority = Priority;
+
+	static void invoke(const EType& event)
+	{
+		static_cast<EventListener<EType>&>(Listener).onEvent(event);
+	}
+};
+
+/*
+ * Compile-time table of static subscriptions.
+ *
+ * The table is resolved entirely at compile time: the subscribers of each event type and their order
+ * are constants, so no hashing or allocation happens at startup and dispatch calls listeners directly.
+ *
+ * @tparam Subscriptions The StaticSubscription entries of the table.
+ */
+template <typename... Subscriptions>
+class StaticSubscriptionTable
+{
+public:
+
+	/// Type-erased view of the table for EventDispatcher.
+	static const StaticTopology topology;
+
+	/*
+	 * Notify all static subscribers of an event, in order of descending priority.
+	 *
+	 * @tparam EType The event type to dispatch.
+	 * @param event The event to dispatch.
+	 */
+	template <EventType EType>
+	static void dispatch(const EType& event)
+	{
+		constexpr auto order = sortedSubscriptions<EType>();
+		[&event, &order]<std::size_t... I>(std::index_sequence<I...>)
+		{
+			(Subscription<order[I]>::invoke(event), ...);
+		}(std::make_index_sequence<order.size()>{});
+	}
+
+	/// Check whether any static subscription exists for an event type.
+	template <EventType EType>
+	static constexpr bool observes() noexcept
+	{
+		return sortedSubscriptions<EType>().size() != 0;
+	}
+
+	static constexpr std::size_t size() noexcept
+	{
+		return sizeof...(Subscriptions);
+	}
+
+private:
+	template <std::size_t I>
+	using Subscription = std::tuple_element_t<I, std::tuple<Subscriptions...>>;
+
+	template <std::size_t I>
+	using EventOf = typename Subscription<I>::Event;
+
+	template <EventType EType>
+	static constexpr std::size_t countOf() noexcept
+	{
+		return (std::size_t{ 0 } + ... + (std::is_same_v<typename Subscriptions::Event, EType> ? 1 : 0));
+	}
+
+	/// Indices of the subscriptions to an event type, sorted by descending priority and stable otherwise.
+	template <EventType EType>
+	static constexpr std::array<std::size_t, countOf<EType>()> sortedSubscriptions() noexcept
+	{
+		constexpr bool matches[] = { std::is_same_v<typename Subscriptions::Event, EType>..., false };
+		constexpr int priorities[] = { Subscriptions::priority..., 0 };
+
+		std::array<std::size_t, countOf<EType>()> order{};
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < sizeof...(Subscriptions); ++i)
+		{
+			if (!matches[i])
+				continue;
+
+			std::size_t position = count++;
+			while (position > 0 && priorities[order[position - 1]] < priorities[i])
+			{
+				order[position] = order[position - 1];
+				--position;
+			}
+			order[position] = i;
+		}
+		return order;
+	}
+
+	/// Whether the subscription at index I is the first one to its event type.
+	template <std::size_t I>
+	static constexpr bool firstOfType() noexcept
+	{
+		return sortedSubscriptions<EventOf<I>>().size() != 0 && []<std::size_t... J>(std::index_sequence<J...>)
+		{
+			return !(std::is_same_v<EventOf<J>, EventOf<I>> || ...);
+		}(std::make_index_sequence<I>{});
+	}
+
+	static void dispatchErased(EventTypeKey key, const void* event)
+	{
+		[key, event]<std::size_t... I>(std::index_sequence<I...>)
+		{
+			(void)((firstOfType<I>() && key == eventTypeKey<EventOf<I>>()
+				&& (dispatch(*static_cast<const EventOf<I>*>(event)), true)) || ...);
+		}(std::make_index_sequence<sizeof...(Subscriptions)>{});
+	}
+
+	static bool observesErased(EventTypeKey key)
+	{
+		return ((key == eventTypeKey<typename Subscriptions::Event>()) || ...);
+	}
+};
+
+template <typename... Subscriptions>
+constinit const StaticTopology StaticSubscriptionTable<Subscriptions...>::topology{
+	&StaticSubscriptionTable::dispatchErased, &StaticSubscriptionTable::observesErased, sizeof...(Subscriptions) };
@@ -0,0 +1,113 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+
+/*
+ * Fixed-size pool of worker threads executing submitted tasks in FIFO order.
+ *
+ * Used by the EventDispatcher to notify independent listeners concurrently.
+ */
+class ThreadPool
+{
+public:
+
+	/*
+	 * Start the worker threads.
+	 *
+	 * @param threads The number of workers, defaults to the number of hardware threads.
+	 */
+	explicit ThreadPool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency()))
+	{
+		workers.reserve(threads);
+		for (std::size_t i = 0; i < threads; ++i)
+			workers.emplace_back([this] { work(); });
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/*
+	 * Stop the workers after all queued tasks have run.
+	 */
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stopping = true;
+		}
+		wakeup.notify_all();
+
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	/*
+	 * Queue a task for execution on one of the workers.
+	 *
+	 * @param task The task to run.
+	 */
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock(mutex);
+			tasks.push_back(std::move(task));
+		}
+		wakeup.notify_one();
+	}
+
+	/*
+	 * Run one queued task on the calling thread, if any.
+	 *
+	 * Lets threads waiting on submitted work help instead of idling.
+	 *
+	 * @return True if a task was run.
+	 */
+	bool runPendingTask()
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard lock(mutex);
+			if (tasks.empty())
+				return false;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+		return true;
+	}
+
+	/// The number of worker threads.
+	std::size_t size() const noexcept
+	{
+		return workers.size();
+	}
+
+private:
+	void work()
+	{
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(mutex);
+				wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+				if (tasks.empty())
+					return;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	bool stopping = false;
+};
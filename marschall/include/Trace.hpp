@@ -0,0 +1,23 @@
+#pragma once
+
+/*
+ * Static tracepoints for observing dispatchers in production with tools like bpftrace or perf.
+ *
+ * With MARSCHALL_USDT defined and sys/sdt.h available, each tracepoint is a USDT probe that compiles to a single
+ * nop until a tracer attaches. Otherwise tracepoints compile to nothing and their arguments are not evaluated.
+ *
+ * Probes of the provider "marschall":
+ *   dispatch__entry(type key), dispatch__exit(type key)
+ *   listener(type key, listener id)
+ *   subscribe(type key, listener id), unsubscribe(type key, listener id)
+ *   queue(type key, queue depth)
+ *   process__entry(queue depth), process__exit(queue depth)
+ */
+#if defined(MARSCHALL_USDT) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define MARSCHALL_TRACE1(name, a) DTRACE_PROBE1(marschall, name, a)
+#define MARSCHALL_TRACE2(name, a, b) DTRACE_PROBE2(marschall, name, a, b)
+#else
+#define MARSCHALL_TRACE1(name, a) ((void)sizeof(a))
+#define MARSCHALL_TRACE2(name, a, b) ((void)sizeof(a), (void)sizeof(b))
+#endif
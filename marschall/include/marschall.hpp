@@ -1,5 +1,28 @@
 #pragma once
 
+#include "Trace.hpp"
 #include "Event.hpp"
 #include "EventListener.hpp"
-#include "EventDispatcher.hpp"
\ No newline at end of file
+#include "EventStream.hpp"
+#include "EventBatch.hpp"
+#include "EventQueue.hpp"
+#include "EventRingBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "QueryReducers.hpp"
+#include "StaticSubscriptions.hpp"
+#include "EventSerialization.hpp"
+#include "EventSpill.hpp"
+#include "SignalEventQueue.hpp"
+#include "EventDispatcher.hpp"
+#include "FixedEventDispatcher.hpp"
+#include "EventTransaction.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include "DurableEventQueue.hpp"
+#include "MappedEventSpill.hpp"
+#include "EventBridge.hpp"
+#endif
+
+#if defined(__linux__)
+#include "EventLoop.hpp"
+#endif
\ No newline at end of file
@@ -1,12 +1,18 @@
 include "./vendor/premake/custom/solution_items.lua"
 
+newoption {
+	trigger = "usdt",
+	description = "Enable USDT tracepoints, requires sys/sdt.h"
+}
+
 workspace "marschall"
 	architecture "x64"
 
 	configurations {
 		"Debug",
 		"Release",
-		"Dist"
+		"Dist",
+		"NoRtti"
 	}
 
 	solution_items {
@@ -40,6 +46,9 @@ project "marschall"
 	filter "system:windows"
 		systemversion "latest"
 
+	filter { "system:linux", "options:usdt" }
+		defines "MARSCHALL_USDT"
+
 
 	filter "configurations:Debug"
 		defines "MARSCHALL_DEBUG"
@@ -53,6 +62,12 @@ project "marschall"
 		defines "MARSCHALL_DIST"
 		optimize "on"
 
+	filter "configurations:NoRtti"
+		defines "MARSCHALL_DIST"
+		optimize "on"
+		rtti "Off"
+		exceptionhandling "Off"
+
 project "marschall-test"
 	kind "ConsoleApp"
 	location "marschall-test"
@@ -79,6 +94,9 @@ project "marschall-test"
 	filter "system:windows"
 		systemversion "latest"
 
+	filter { "system:linux", "options:usdt" }
+		defines "MARSCHALL_USDT"
+
 
 	filter "configurations:Debug"
 		defines "MARSCHALL_TEST_DEBUG"
@@ -90,4 +108,56 @@ project "marschall-test"
 
 	filter "configurations:Dist"
 		defines "MARSCHALL_TEST_DIST"
-		optimize "on"
\ No newline at end of file
+		optimize "on"
+
+	filter "configurations:NoRtti"
+		defines "MARSCHALL_TEST_DIST"
+		optimize "on"
+		rtti "Off"
+		exceptionhandling "Off"
+		postbuildcommands { "\"%{cfg.buildtarget.abspath}\"" }
+
+project "marschall-bench"
+	kind "ConsoleApp"
+	location "marschall-bench"
+	language "C++"
+	cppdialect "C++23"
+	staticruntime "off"
+
+	targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files {
+		"%{prj.location}/src/**.hpp",
+		"%{prj.location}/src/**.cpp"
+	}
+
+	includedirs {
+		"%{wks.location}/marschall/include"
+	}
+
+
+	filter "system:windows"
+		systemversion "latest"
+
+	filter { "system:linux", "options:usdt" }
+		defines "MARSCHALL_USDT"
+
+
+	filter "configurations:Debug"
+		defines "MARSCHALL_BENCH_DEBUG"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "MARSCHALL_BENCH_RELEASE"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines "MARSCHALL_BENCH_DIST"
+		optimize "on"
+
+	filter "configurations:NoRtti"
+		defines "MARSCHALL_BENCH_DIST"
+		optimize "on"
+		rtti "Off"
+		exceptionhandling "Off"